@@ -0,0 +1,471 @@
+// hatariB headless benchmark
+//
+// Links the core directly and runs it without a frontend:
+// null video, audio and input, as fast as possible.
+//
+// usage: hatarib_bench [options] [content]
+//   -frames N     frames to measure (default 3000)
+//   -warmup N     frames to run before measuring (default 300)
+//   -av N         GET_AUDIO_VIDEO_ENABLE value (default 3, 0 = all frames hidden)
+//   -runahead N   simulate same-instance run-ahead of N frames (serialize, run hidden, unserialize)
+//   -system DIR   system directory (default "system")
+//   -saves DIR    save directory (default "saves")
+//   -state FILE   savestate to restore before running (e.g. the start of an input movie)
+//   -save FILE    savestate to write after the last frame (e.g. to compare options that should not change emulation)
+//   -occupancy N  report frontend audio buffer occupancy of N% for frameskip
+//   -hold ID A B  hold RetroPad button ID (RETRO_DEVICE_ID_JOYPAD_*) on port 0 for measured frames A to B
+//   -throttle N   GET_THROTTLE_STATE mode (e.g. 2 = fast-forward, 6 = unblocked for hatarib_turbo), default unsupported
+//   -nodupe       GET_CAN_DUPE unsupported, every frame is sent
+//   -video FILE   write a hash of each shown frame (a dupe repeats the last one), to compare with -nodupe
+//   -audio FILE   write the measured frames' audio as raw 16-bit stereo, to compare audio changes
+//   -o KEY=VALUE  core option, can be repeated (e.g. -o hatarib_machine=1)
+//   -v            show core log
+
+#include "../libretro/libretro.h"
+#include "../core/core.h"
+#include "../core/core_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+#define MAX_OPTIONS   64
+
+static int bench_av = 3;
+static int bench_context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+static bool bench_verbose = false;
+static const char* bench_system = "system";
+static const char* bench_saves = "saves";
+static const char* option_key[MAX_OPTIONS];
+static const char* option_value[MAX_OPTIONS];
+static int option_count = 0;
+static int bench_occupancy = -1; // simulated frontend audio buffer occupancy %, -1 = no audio buffer status
+static retro_audio_buffer_status_callback_t bench_audio_status = NULL;
+static unsigned bench_audio_latency = 0;
+static int bench_dupes = 0;
+static bool bench_can_dupe = true;
+static FILE* bench_video_log = NULL;
+static uint64_t bench_video_hash = 0; // last frame sent
+static unsigned bench_video_width = 0;
+static unsigned bench_video_height = 0;
+static FILE* bench_audio_log = NULL;
+static int bench_audio_calls = 0; // audio_batch_cb calls in this retro_run
+static int bench_audio_calls_max = 0;
+static long long bench_audio_samples = 0; // stereo samples in the measured frames
+static unsigned bench_pixel_bytes = 2; // RETRO_PIXEL_FORMAT_0RGB1555 until set
+static int bench_throttle = -1; // RETRO_THROTTLE_* mode to report, -1 = no throttle state
+static int bench_hold_id = -1; // held RetroPad button
+static int bench_hold_first = 0;
+static int bench_hold_last = -1;
+static int bench_frame = -1; // measured frame, -1 during warmup
+
+static retro_time_t bench_time_usec(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (retro_time_t)((c.QuadPart * 1000000) / f.QuadPart);
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return ((retro_time_t)tv.tv_sec * 1000000) + tv.tv_usec;
+#endif
+}
+
+//
+// libretro callbacks
+//
+
+static void bench_log(enum retro_log_level level, const char* fmt, ...)
+{
+	if (!bench_verbose && level < RETRO_LOG_WARN) return;
+	va_list args;
+	va_start(args,fmt);
+	vfprintf(stderr,fmt,args);
+	va_end(args);
+}
+
+static bool bench_environment(unsigned cmd, void* data)
+{
+	switch (cmd)
+	{
+	case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+		((struct retro_log_callback*)data)->log = bench_log;
+		return true;
+	case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+		{
+			struct retro_perf_callback* perf = (struct retro_perf_callback*)data;
+			memset(perf,0,sizeof(*perf));
+			perf->get_time_usec = bench_time_usec;
+		}
+		return true;
+	case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+		*(const char**)data = bench_system;
+		return true;
+	case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+		*(const char**)data = bench_saves;
+		return true;
+	case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+		*(int*)data = bench_av;
+		return true;
+	case RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT:
+		*(int*)data = bench_context;
+		return true;
+	case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+		*(bool*)data = bench_can_dupe;
+		return true;
+	case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+		bench_pixel_bytes = (*(const enum retro_pixel_format*)data == RETRO_PIXEL_FORMAT_XRGB8888) ? 4 : 2;
+		return true;
+	case RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK:
+		if (bench_occupancy < 0) return false;
+		bench_audio_status = data ? ((const struct retro_audio_buffer_status_callback*)data)->callback : NULL;
+		return true;
+	case RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY:
+		bench_audio_latency = *(const unsigned*)data;
+		return true;
+	case RETRO_ENVIRONMENT_GET_THROTTLE_STATE:
+		if (bench_throttle < 0) return false;
+		((struct retro_throttle_state*)data)->mode = (unsigned)bench_throttle;
+		((struct retro_throttle_state*)data)->rate = 0.0f;
+		return true;
+	case RETRO_ENVIRONMENT_GET_VARIABLE:
+		{
+			struct retro_variable* var = (struct retro_variable*)data;
+			for (int i=0; i<option_count; ++i)
+			{
+				if (!strcmp(option_key[i],var->key))
+				{
+					var->value = option_value[i];
+					return true;
+				}
+			}
+			var->value = NULL;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+static void bench_video(const void* data, unsigned width, unsigned height, size_t pitch)
+{
+	if (!data) ++bench_dupes;
+	if (!bench_video_log || !(bench_av & 1)) return; // shown frames only
+	if (data)
+	{
+		uint64_t h = 0xCBF29CE484222325ULL;
+		for (unsigned y=0; y<height; ++y)
+		{
+			const uint8_t* line = (const uint8_t*)data + (y * pitch);
+			for (unsigned x=0; x<(width * bench_pixel_bytes); ++x)
+				h = (h ^ line[x]) * 0x100000001B3ULL;
+		}
+		bench_video_hash = h;
+		bench_video_width = width;
+		bench_video_height = height;
+	}
+	if (bench_frame >= 0) // a dupe during the measured frames repeats the last frame of the warmup
+		fprintf(bench_video_log,"%5d %016llx %ux%u\n",bench_frame,(unsigned long long)bench_video_hash,bench_video_width,bench_video_height);
+}
+static size_t bench_audio_batch(const int16_t* data, size_t frames)
+{
+	++bench_audio_calls;
+	if (bench_frame < 0) return frames;
+	bench_audio_samples += frames;
+	if (bench_audio_log) fwrite(data,sizeof(int16_t)*2,frames,bench_audio_log);
+	return frames;
+}
+static void bench_audio(int16_t left, int16_t right) { (void)left; (void)right; }
+static void bench_input_poll(void) {}
+static int16_t bench_input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+	(void)index;
+	return (port == 0 && device == RETRO_DEVICE_JOYPAD && (int)id == bench_hold_id &&
+		bench_frame >= bench_hold_first && bench_frame <= bench_hold_last) ? 1 : 0;
+}
+
+//
+// benchmark
+//
+
+static void bench_run(void)
+{
+	// the frontend reports its audio buffer status before each retro_run, underruns are likely below 25%
+	if (bench_audio_status) bench_audio_status(true, (unsigned)bench_occupancy, bench_occupancy < 25);
+	bench_audio_calls = 0;
+	retro_run();
+	if (bench_frame >= 0 && bench_audio_calls > bench_audio_calls_max) bench_audio_calls_max = bench_audio_calls;
+}
+
+static int compare_time(const void* a, const void* b)
+{
+	retro_time_t ta = *(const retro_time_t*)a;
+	retro_time_t tb = *(const retro_time_t*)b;
+	return (ta > tb) - (ta < tb);
+}
+
+static uint8_t* load_file(const char* filename, size_t* size)
+{
+	FILE* f = fopen(filename,"rb");
+	if (!f) return NULL;
+	fseek(f,0,SEEK_END);
+	long len = ftell(f);
+	fseek(f,0,SEEK_SET);
+	uint8_t* data = malloc(len > 0 ? len : 1);
+	if (data && fread(data,1,len,f) != (size_t)len)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*size = (size_t)len;
+	return data;
+}
+
+static void usage(void)
+{
+	printf(
+		"usage: hatarib_bench [options] [content]\n"
+		"  -frames N     frames to measure (default 3000)\n"
+		"  -warmup N     frames to run before measuring (default 300)\n"
+		"  -av N         GET_AUDIO_VIDEO_ENABLE value (default 3, 0 = all frames hidden)\n"
+		"  -runahead N   simulate same-instance run-ahead of N frames\n"
+		"  -system DIR   system directory (default \"system\")\n"
+		"  -saves DIR    save directory (default \"saves\")\n"
+		"  -state FILE   savestate to restore before running\n"
+		"  -save FILE    savestate to write after the last frame\n"
+		"  -occupancy N  report frontend audio buffer occupancy of N%% for frameskip\n"
+		"  -hold ID A B  hold RetroPad button ID on port 0 for measured frames A to B\n"
+		"  -throttle N   report GET_THROTTLE_STATE mode N (2 = fast-forward, 6 = unblocked)\n"
+		"  -nodupe       report GET_CAN_DUPE unsupported\n"
+		"  -video FILE   write a hash of each shown frame, dupes repeat the last\n"
+		"  -audio FILE   write the measured audio as raw 16-bit stereo\n"
+		"  -o KEY=VALUE  core option, can be repeated\n"
+		"  -v            show core log\n");
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 3000;
+	int warmup = 300;
+	int runahead = 0;
+	const char* content = NULL;
+	const char* state_file = NULL;
+	const char* save_file = NULL;
+	const char* video_file = NULL;
+	const char* audio_file = NULL;
+
+	for (int i=1; i<argc; ++i)
+	{
+		const char* a = argv[i];
+		bool more = (i+1) < argc;
+		if      (!strcmp(a,"-frames") && more) frames = atoi(argv[++i]);
+		else if (!strcmp(a,"-warmup") && more) warmup = atoi(argv[++i]);
+		else if (!strcmp(a,"-av") && more) bench_av = atoi(argv[++i]);
+		else if (!strcmp(a,"-runahead") && more) runahead = atoi(argv[++i]);
+		else if (!strcmp(a,"-system") && more) bench_system = argv[++i];
+		else if (!strcmp(a,"-saves") && more) bench_saves = argv[++i];
+		else if (!strcmp(a,"-state") && more) state_file = argv[++i];
+		else if (!strcmp(a,"-save") && more) save_file = argv[++i];
+		else if (!strcmp(a,"-occupancy") && more) bench_occupancy = atoi(argv[++i]);
+		else if (!strcmp(a,"-throttle") && more) bench_throttle = atoi(argv[++i]);
+		else if (!strcmp(a,"-nodupe")) bench_can_dupe = false;
+		else if (!strcmp(a,"-video") && more) video_file = argv[++i];
+		else if (!strcmp(a,"-audio") && more) audio_file = argv[++i];
+		else if (!strcmp(a,"-hold") && (i+3) < argc)
+		{
+			bench_hold_id = atoi(argv[++i]);
+			bench_hold_first = atoi(argv[++i]);
+			bench_hold_last = atoi(argv[++i]);
+		}
+		else if (!strcmp(a,"-o") && more && option_count < MAX_OPTIONS)
+		{
+			char* kv = argv[++i];
+			char* eq = strchr(kv,'=');
+			if (!eq) { usage(); return 1; }
+			*eq = 0;
+			option_key[option_count] = kv;
+			option_value[option_count] = eq+1;
+			++option_count;
+		}
+		else if (!strcmp(a,"-v")) bench_verbose = true;
+		else if (a[0] != '-' && !content) content = a;
+		else { usage(); return 1; }
+	}
+	if (frames < 1) frames = 1;
+	if (video_file)
+	{
+		bench_video_log = fopen(video_file,"wt");
+		if (!bench_video_log)
+		{
+			printf("Unable to write video hashes: %s\n",video_file);
+			return 1;
+		}
+	}
+	if (audio_file)
+	{
+		bench_audio_log = fopen(audio_file,"wb");
+		if (!bench_audio_log)
+		{
+			printf("Unable to write audio: %s\n",audio_file);
+			return 1;
+		}
+	}
+
+	retro_set_environment(bench_environment);
+	retro_set_video_refresh(bench_video);
+	retro_set_audio_sample_batch(bench_audio_batch);
+	retro_set_audio_sample(bench_audio);
+	retro_set_input_poll(bench_input_poll);
+	retro_set_input_state(bench_input_state);
+	retro_init();
+
+	struct retro_game_info game;
+	memset(&game,0,sizeof(game));
+	uint8_t* game_data = NULL;
+	if (content)
+	{
+		size_t size = 0;
+		game_data = load_file(content,&size);
+		if (!game_data)
+		{
+			printf("Unable to load content: %s\n",content);
+			return 1;
+		}
+		game.path = content;
+		game.data = game_data;
+		game.size = size;
+	}
+	if (!retro_load_game(content ? &game : NULL))
+	{
+		printf("retro_load_game failed.\n");
+		return 1;
+	}
+
+	size_t state_size = retro_serialize_size();
+	uint8_t* state = runahead ? malloc(state_size) : NULL;
+	retro_time_t* frame_time = malloc(sizeof(retro_time_t) * frames);
+	if ((runahead && !state) || !frame_time)
+	{
+		printf("Out of memory.\n");
+		return 1;
+	}
+
+	if (state_file)
+	{
+		size_t size = 0;
+		uint8_t* data = load_file(state_file,&size);
+		if (!data || !retro_unserialize(data,size))
+		{
+			printf("Unable to restore savestate: %s\n",state_file);
+			return 1;
+		}
+		free(data);
+	}
+
+	for (int i=0; i<warmup; ++i)
+		bench_run();
+
+	retro_time_t perf_start[4];
+	core_perf_totals(&perf_start[0],&perf_start[1],&perf_start[2],&perf_start[3]);
+	bench_dupes = 0;
+	core_idle_skip_cycles = 0;
+#if CORE_PREDECODE_TEST
+	core_predecode_hits = core_predecode_misses = 0;
+#endif
+	int serialize_count = 0;
+	int unserialize_count = 0;
+	retro_time_t start = bench_time_usec();
+	for (int i=0; i<frames; ++i)
+	{
+		bench_frame = i;
+		retro_time_t t0 = bench_time_usec();
+		if (runahead)
+		{
+			// RetroArch same-instance run-ahead: the real frame and the following frames are hidden,
+			// the last speculative frame is shown, then the state after the real frame is restored
+			int av = bench_av;
+			bench_av = 0;
+			bench_run();
+			bench_context = RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE;
+			retro_serialize(state,state_size); ++serialize_count;
+			bench_context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+			for (int j=1; j<runahead; ++j) bench_run();
+			bench_av = av;
+			bench_run();
+			bench_context = RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE;
+			retro_unserialize(state,state_size); ++unserialize_count;
+			bench_context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+		}
+		else
+		{
+			bench_run();
+		}
+		frame_time[i] = bench_time_usec() - t0;
+	}
+	retro_time_t total = bench_time_usec() - start;
+	retro_time_t perf_end[4];
+	core_perf_totals(&perf_end[0],&perf_end[1],&perf_end[2],&perf_end[3]);
+
+	qsort(frame_time,frames,sizeof(retro_time_t),compare_time);
+	#define PERCENTILE(p_) ((long long)frame_time[((frames-1) * (p_)) / 100])
+	printf("content:     %s\n", content ? content : "(none)");
+	printf("frames:      %d (+%d warmup)", frames, warmup);
+	if (runahead) printf(" run-ahead %d", runahead);
+	printf("\n");
+	printf("total:       %.3f s\n", (double)total / 1000000.0);
+	printf("fps:         %.1f\n", (total > 0) ? ((double)frames * 1000000.0 / (double)total) : 0.0);
+	printf("dupes:       %d", bench_dupes);
+	if (bench_audio_latency) printf(" (minimum audio latency %u ms)", bench_audio_latency);
+	printf("\n");
+	printf("audio:       %lld samples, at most %d audio_batch_cb calls per frame\n", bench_audio_samples, bench_audio_calls_max);
+	printf("idle skip:   %llu CPU cycles\n", (unsigned long long)core_idle_skip_cycles);
+#if CORE_PREDECODE_TEST
+	{
+		uint64_t lookups = core_predecode_hits + core_predecode_misses;
+		printf("predecode:   %llu instructions, %.2f%% hit\n", (unsigned long long)lookups,
+			lookups ? ((double)core_predecode_hits * 100.0 / (double)lookups) : 0.0);
+	}
+#endif
+	printf("frame us:    avg %lld  p50 %lld  p90 %lld  p99 %lld  max %lld\n",
+		(long long)(total / frames),
+		PERCENTILE(50), PERCENTILE(90), PERCENTILE(99),
+		(long long)frame_time[frames-1]);
+	printf("PERF_RUN:         %10lld us total, %6lld us per retro_run\n",
+		(long long)(perf_end[0]-perf_start[0]),
+		(long long)((perf_end[0]-perf_start[0]) / (frames * (runahead ? (runahead+1) : 1))));
+	printf("PERF_RUN_RESET:   %10lld us total\n",
+		(long long)(perf_end[1]-perf_start[1]));
+	printf("PERF_SERIALIZE:   %10lld us total, %6lld us per call\n",
+		(long long)(perf_end[2]-perf_start[2]),
+		(long long)(serialize_count ? ((perf_end[2]-perf_start[2]) / serialize_count) : 0));
+	printf("PERF_UNSERIALIZE: %10lld us total, %6lld us per call\n",
+		(long long)(perf_end[3]-perf_start[3]),
+		(long long)(unserialize_count ? ((perf_end[3]-perf_start[3]) / unserialize_count) : 0));
+
+	if (save_file)
+	{
+		uint8_t* data = malloc(state_size);
+		FILE* f = fopen(save_file,"wb");
+		if (!data || !f || !retro_serialize(data,state_size) || fwrite(data,1,state_size,f) != state_size)
+			printf("Unable to write savestate: %s\n",save_file);
+		if (f) fclose(f);
+		free(data);
+	}
+
+	retro_unload_game();
+	retro_deinit();
+	if (bench_video_log) fclose(bench_video_log);
+	if (bench_audio_log) fclose(bench_audio_log);
+	free(frame_time);
+	free(state);
+	free(game_data);
+	return 0;
+}
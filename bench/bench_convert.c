@@ -0,0 +1,237 @@
+// hatariB screen conversion micro-benchmark
+//
+// Converts a random ST low/medium resolution screen to 32-bit pixels
+// with the scalar routines (hatari/src/convert/macros.h) and the SIMD
+// kernels (hatari/src/convert/simd.h), checks that the results match,
+// and times both.
+//
+// usage: hatarib_bench_convert [frames]
+
+#include <SDL_stdinc.h>
+#include <SDL_endian.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+#include "../hatari/src/convert/macros.h"
+#include "../hatari/src/convert/simd.h"
+
+#define LINES        200
+#define LINE_BYTES   160
+#define BLOCKS_LOW   (LINE_BYTES / 8)
+#define BLOCKS_MED   (LINE_BYTES / 4)
+
+static Uint32 STRGBPalette[16];
+static Uint32 st_screen[LINES * LINE_BYTES / 4];
+static Uint32 out_scalar[LINES * 640];
+static Uint32 out_simd[LINES * 640];
+
+static long long bench_time_usec(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (long long)((c.QuadPart * 1000000) / f.QuadPart);
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return ((long long)tv.tv_sec * 1000000) + tv.tv_usec;
+#endif
+}
+
+//
+// scalar, same block order as convert/low320x32.c, low640x32.c, med640x32.c
+//
+
+static void scalar_low320(void)
+{
+	Uint32 *edi = st_screen;
+	Uint32 *esi = out_scalar;
+	Uint32 eax, edx, ebx, ecx;
+	for (int i=0; i<LINES*BLOCKS_LOW; ++i)
+	{
+		ebx = *edi;
+		ecx = *(edi+1);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		LOW_BUILD_PIXELS_0; PLOT_LOW_320_32BIT(12);
+		LOW_BUILD_PIXELS_1; PLOT_LOW_320_32BIT(4);
+		LOW_BUILD_PIXELS_2; PLOT_LOW_320_32BIT(8);
+		LOW_BUILD_PIXELS_3; PLOT_LOW_320_32BIT(0);
+#else
+		LOW_BUILD_PIXELS_0; PLOT_LOW_320_32BIT(4);
+		LOW_BUILD_PIXELS_1; PLOT_LOW_320_32BIT(12);
+		LOW_BUILD_PIXELS_2; PLOT_LOW_320_32BIT(0);
+		LOW_BUILD_PIXELS_3; PLOT_LOW_320_32BIT(8);
+#endif
+		esi += 16;
+		edi += 2;
+	}
+}
+
+static void scalar_low640(void)
+{
+	Uint32 *edi = st_screen;
+	Uint32 *esi = out_scalar;
+	Uint32 eax, edx, ebx, ecx;
+	for (int i=0; i<LINES*BLOCKS_LOW; ++i)
+	{
+		ebx = *edi;
+		ecx = *(edi+1);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		LOW_BUILD_PIXELS_0; PLOT_LOW_640_32BIT(24);
+		LOW_BUILD_PIXELS_1; PLOT_LOW_640_32BIT(8);
+		LOW_BUILD_PIXELS_2; PLOT_LOW_640_32BIT(16);
+		LOW_BUILD_PIXELS_3; PLOT_LOW_640_32BIT(0);
+#else
+		LOW_BUILD_PIXELS_0; PLOT_LOW_640_32BIT(8);
+		LOW_BUILD_PIXELS_1; PLOT_LOW_640_32BIT(24);
+		LOW_BUILD_PIXELS_2; PLOT_LOW_640_32BIT(0);
+		LOW_BUILD_PIXELS_3; PLOT_LOW_640_32BIT(16);
+#endif
+		esi += 32;
+		edi += 2;
+	}
+}
+
+static void scalar_med640(void)
+{
+	Uint32 *edi = st_screen;
+	Uint32 *esi = out_scalar;
+	Uint32 eax, ebx, ecx;
+	for (int i=0; i<LINES*BLOCKS_MED; ++i)
+	{
+		ebx = *edi;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		MED_BUILD_PIXELS_0; PLOT_MED_640_32BIT(12);
+		MED_BUILD_PIXELS_1; PLOT_MED_640_32BIT(4);
+		MED_BUILD_PIXELS_2; PLOT_MED_640_32BIT(8);
+		MED_BUILD_PIXELS_3; PLOT_MED_640_32BIT(0);
+#else
+		MED_BUILD_PIXELS_0; PLOT_MED_640_32BIT(4);
+		MED_BUILD_PIXELS_1; PLOT_MED_640_32BIT(12);
+		MED_BUILD_PIXELS_2; PLOT_MED_640_32BIT(0);
+		MED_BUILD_PIXELS_3; PLOT_MED_640_32BIT(8);
+#endif
+		esi += 16;
+		edi += 1;
+	}
+}
+
+//
+// SIMD
+//
+
+#if CONVERT_SIMD
+
+CONVERT_SIMD_TARGET
+static void simd_low320(void)
+{
+	ConvertSimdPalette pal;
+	const Uint8 *edi = (const Uint8 *)st_screen;
+	Uint32 *esi = out_simd;
+	ConvertSimd_SetPalette(&pal, STRGBPalette);
+	for (int i=0; i<LINES*BLOCKS_LOW; ++i)
+	{
+		ConvertSimd_Plot16(esi, ConvertSimd_LowPixels(edi), &pal);
+		esi += 16;
+		edi += 8;
+	}
+}
+
+CONVERT_SIMD_TARGET
+static void simd_low640(void)
+{
+	ConvertSimdPalette pal;
+	const Uint8 *edi = (const Uint8 *)st_screen;
+	Uint32 *esi = out_simd;
+	ConvertSimd_SetPalette(&pal, STRGBPalette);
+	for (int i=0; i<LINES*BLOCKS_LOW; ++i)
+	{
+		ConvertSimd_Plot16Double(esi, ConvertSimd_LowPixels(edi), &pal);
+		esi += 32;
+		edi += 8;
+	}
+}
+
+CONVERT_SIMD_TARGET
+static void simd_med640(void)
+{
+	ConvertSimdPalette pal;
+	const Uint8 *edi = (const Uint8 *)st_screen;
+	Uint32 *esi = out_simd;
+	ConvertSimd_SetPalette(&pal, STRGBPalette);
+	for (int i=0; i<LINES*BLOCKS_MED; ++i)
+	{
+		ConvertSimd_Plot16(esi, ConvertSimd_MedPixels(edi), &pal);
+		esi += 16;
+		edi += 4;
+	}
+}
+
+#endif
+
+static long long run(void (*convert)(void), int frames)
+{
+	long long t0 = bench_time_usec();
+	for (int i=0; i<frames; ++i)
+		convert();
+	return bench_time_usec() - t0;
+}
+
+static int test(const char* name, void (*scalar)(void), void (*simd)(void), size_t pixels, int frames)
+{
+	long long ts, tv;
+	int result = 0;
+
+	memset(out_scalar,0,sizeof(out_scalar));
+	scalar();
+	ts = run(scalar,frames);
+	printf("%-8s scalar %8.1f us/frame",name,(double)ts/frames);
+	if (simd)
+	{
+		memset(out_simd,0,sizeof(out_simd));
+		simd();
+		tv = run(simd,frames);
+		result = memcmp(out_scalar,out_simd,pixels*sizeof(Uint32)) ? 1 : 0;
+		printf("  simd %8.1f us/frame  %5.2fx  %s",(double)tv/frames,(tv > 0) ? ((double)ts/(double)tv) : 0.0,
+			result ? "MISMATCH" : "match");
+	}
+	printf("\n");
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = (argc > 1) ? atoi(argv[1]) : 2000;
+	void (*simd[3])(void) = { NULL, NULL, NULL };
+	int result = 0;
+
+	if (frames < 1) frames = 1;
+	srand(1);
+	for (size_t i=0; i<sizeof(st_screen); ++i)
+		((Uint8*)st_screen)[i] = (Uint8)(rand() >> 4);
+	for (int i=0; i<16; ++i)
+		STRGBPalette[i] = ((Uint32)(rand() & 0xFFFF) << 16) ^ (Uint32)rand();
+
+#if CONVERT_SIMD
+	if (ConvertSimd_Available())
+	{
+		simd[0] = simd_low320;
+		simd[1] = simd_low640;
+		simd[2] = simd_med640;
+	}
+	else
+#endif
+		printf("SIMD conversion not available on this host.\n");
+
+	result |= test("low320",scalar_low320,simd[0],LINES*320,frames);
+	result |= test("low640",scalar_low640,simd[1],LINES*640,frames);
+	result |= test("med640",scalar_med640,simd[2],LINES*640,frames);
+	return result;
+}
@@ -0,0 +1,248 @@
+// hatariB CycInt scheduler micro-benchmark
+//
+// Runs a synthetic interrupt workload through Hatari's CycInt API
+// (hatari/src/cycInt.c, a sorted linked list) and through a binary
+// min-heap giving the same order, checks that both fire the interrupts
+// in the same order, and times both. See DEVELOP.md, CycInt Scheduler.
+//
+// The workload keeps a number of periodic interrupts active, like the
+// video, MFP timer, crossbar and sound ones on a Falcon: each one that
+// fires is rescheduled, some others are modified or removed and re-added.
+//
+// usage: hatarib_bench_cycint [events] [active]
+
+#include "../hatari/src/includes/main.h"
+#include "../hatari/src/includes/cycles.h"
+#include "../hatari/src/includes/cycInt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+extern bool CpuRunCycleExact; // m68000.h needs the UAE CPU headers
+
+static long long bench_time_usec(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (long long)((c.QuadPart * 1000000) / f.QuadPart);
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return ((long long)tv.tv_sec * 1000000) + tv.tv_usec;
+#endif
+}
+
+//
+// alternative: a binary min-heap with the same order as the CycInt list,
+// by Cycles, then the most recently inserted first
+//
+
+static bool heap_active[MAX_INTERRUPTS];
+static uint64_t heap_cycles[MAX_INTERRUPTS];
+static uint64_t heap_order[MAX_INTERRUPTS];
+static int heap[MAX_INTERRUPTS];
+static int heap_pos[MAX_INTERRUPTS];
+static int heap_size;
+static uint64_t heap_count;
+
+static inline bool heap_before(int a, int b)
+{
+	if (heap_cycles[a] != heap_cycles[b]) return heap_cycles[a] < heap_cycles[b];
+	return heap_order[a] > heap_order[b];
+}
+
+static void heap_up(int pos)
+{
+	int id = heap[pos];
+	while (pos > 0)
+	{
+		int parent = (pos - 1) / 2;
+		if (!heap_before(id,heap[parent])) break;
+		heap[pos] = heap[parent];
+		heap_pos[heap[pos]] = pos;
+		pos = parent;
+	}
+	heap[pos] = id;
+	heap_pos[id] = pos;
+}
+
+static void heap_down(int pos)
+{
+	int id = heap[pos];
+	int child;
+	while ((child = (pos * 2) + 1) < heap_size)
+	{
+		if ((child + 1) < heap_size && heap_before(heap[child+1],heap[child])) ++child;
+		if (!heap_before(heap[child],id)) break;
+		heap[pos] = heap[child];
+		heap_pos[heap[pos]] = pos;
+		pos = child;
+	}
+	heap[pos] = id;
+	heap_pos[id] = pos;
+}
+
+static void heap_insert(int id)
+{
+	heap_order[id] = ++heap_count;
+	heap[heap_size] = id;
+	heap_up(heap_size++);
+}
+
+static void heap_remove(int id)
+{
+	if (!heap_active[id]) return;
+	heap_active[id] = false;
+	int pos = heap_pos[id];
+	int last = heap[--heap_size];
+	if (pos < heap_size)
+	{
+		heap[pos] = last;
+		if (pos > 0 && heap_before(last,heap[(pos-1)/2])) heap_up(pos);
+		else heap_down(pos);
+	}
+}
+
+static void heap_reset(void)
+{
+	for (int i=0; i<MAX_INTERRUPTS; ++i)
+	{
+		heap_active[i] = false;
+		heap_cycles[i] = 0;
+	}
+	heap_size = 0;
+	heap_count = 0;
+	// interrupt 0 is always active and never triggers
+	heap_active[0] = true;
+	heap_cycles[0] = UINT64_MAX;
+	heap_insert(0);
+}
+
+static void heap_add_relative(int cycles, int id)
+{
+	heap_remove(id);
+	heap_active[id] = true;
+	heap_cycles[id] = ((int64_t)cycles << CYCINT_SHIFT) + (CyclesGlobalClockCounter << CYCINT_SHIFT);
+	heap_insert(id);
+}
+
+static void heap_modify(int cycles, int id)
+{
+	heap_remove(id);
+	heap_active[id] = true;
+	heap_cycles[id] += (int64_t)cycles << CYCINT_SHIFT;
+	heap_insert(id);
+}
+
+//
+// workload
+//
+
+static int period[MAX_INTERRUPTS];
+static uint32_t rng;
+
+static uint32_t bench_rand(void)
+{
+	rng = rng * 1103515245 + 12345;
+	return rng >> 8;
+}
+
+static void setup(int active)
+{
+	// a spread of periods from a few CPU cycles (crossbar, DSP) to a frame (VBL)
+	static const int periods[] = { 8, 20, 64, 128, 160, 224, 512, 512, 1024, 2048, 2500, 5000, 10000, 20000, 40000, 80000, 160000 };
+	rng = 1;
+	for (int i=1; i<MAX_INTERRUPTS; ++i)
+		period[i] = (i <= active) ? periods[(i-1) % (sizeof(periods)/sizeof(periods[0]))] : 0;
+}
+
+// event loop shared by both schedulers: fire the first interrupt, reschedule it,
+// and sometimes modify or restart another one
+#define WORKLOAD(head_, cycles_, ack_, add_relative_, modify_, remove_, active_) \
+	do { \
+		CyclesGlobalClockCounter = 0; \
+		for (int i=1; i<MAX_INTERRUPTS; ++i) \
+			if (period[i]) add_relative_((int)(bench_rand() % period[i]) + 1, i); \
+		for (int e=0; e<events; ++e) \
+		{ \
+			int id = (head_); \
+			CyclesGlobalClockCounter = (cycles_) >> CYCINT_SHIFT; \
+			ack_; \
+			hash = (hash * 31) + (uint64_t)id + CyclesGlobalClockCounter; \
+			add_relative_(period[id] + (int)(bench_rand() & 3), id); \
+			uint32_t r = bench_rand(); \
+			int other = 1 + (int)((r >> 4) % (MAX_INTERRUPTS-1)); \
+			if (!period[other] || other == id) continue; \
+			switch (r & 15) \
+			{ \
+			case 0: if (active_(other)) modify_((int)((r >> 12) % 64), other); break; \
+			case 1: remove_(other); add_relative_(period[other], other); break; \
+			} \
+		} \
+	} while (0)
+
+#define HEAP_HEAD       heap[0]
+#define HEAP_CYCLES     heap_cycles[heap[0]]
+#define HEAP_ACK        heap_remove(heap[0])
+#define HEAP_ACTIVE(i_) heap_active[i_]
+
+#define CYC_HEAD        CycInt_GetActiveInt()
+#define CYC_CYCLES      CycInt_ActiveInt_Cycles
+#define CYC_ACK         CycInt_AcknowledgeInterrupt()
+#define CYC_ADD(c_,i_)  CycInt_AddRelativeInterrupt((c_),INT_CPU_CYCLE,(interrupt_id)(i_))
+#define CYC_MOD(c_,i_)  CycInt_ModifyInterrupt((c_),INT_CPU_CYCLE,(interrupt_id)(i_))
+#define CYC_REM(i_)     CycInt_RemovePendingInterrupt((interrupt_id)(i_))
+#define CYC_ACTIVE(i_)  CycInt_InterruptActive((interrupt_id)(i_))
+
+static uint64_t run_heap(int events, int active)
+{
+	uint64_t hash = 0;
+	setup(active);
+	heap_reset();
+	WORKLOAD(HEAP_HEAD, HEAP_CYCLES, HEAP_ACK, heap_add_relative, heap_modify, heap_remove, HEAP_ACTIVE);
+	return hash;
+}
+
+static uint64_t run_cycint(int events, int active)
+{
+	uint64_t hash = 0;
+	setup(active);
+	CycInt_Reset();
+	WORKLOAD(CYC_HEAD, CYC_CYCLES, CYC_ACK, CYC_ADD, CYC_MOD, CYC_REM, CYC_ACTIVE);
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	int events = (argc > 1) ? atoi(argv[1]) : 10000000;
+	int max_active = (argc > 2) ? atoi(argv[2]) : 0;
+	int result = 0;
+
+	if (events < 1) events = 1;
+	CpuRunCycleExact = false;
+
+	for (int active = 4; active < MAX_INTERRUPTS; active += 7)
+	{
+		if (max_active > 0 && active > max_active) break;
+		long long t0 = bench_time_usec();
+		uint64_t h_cyc = run_cycint(events,active);
+		long long t1 = bench_time_usec();
+		uint64_t h_heap = run_heap(events,active);
+		long long t2 = bench_time_usec();
+		printf("%2d active: CycInt %7.2f ns/event, heap %7.2f ns/event%s\n",
+			active,
+			(double)(t1-t0) * 1000.0 / (double)events,
+			(double)(t2-t1) * 1000.0 / (double)events,
+			(h_cyc == h_heap) ? "" : "  MISMATCH");
+		if (h_cyc != h_heap) result = 1;
+	}
+	CycInt_Reset();
+	return result;
+}
@@ -0,0 +1,310 @@
+// hatariB Falcon DSP check and micro-benchmark
+//
+// Drives Hatari's DSP56001 emulation (hatari/src/falcon) directly, with a
+// simulated CPU using the same host port functions as the 68030, to check
+// the hatarib_dsp_cache and hatarib_dsp_lazy options against the original
+// behaviour, and time them. See DEVELOP.md, Changes to Hatari, dsp.c and dsp_cpu.c.
+//
+// The decode cache is checked with a DSP program that writes an instruction,
+// executes it, rewrites it and executes it again: in internal P RAM below $100
+// and above it, in external P RAM, and through external X RAM (which is also
+// P memory on the Falcon). Each rewritten instruction must take effect.
+//
+// Lazy catch-up is checked by bootstrapping a DSP program that sums the words
+// it receives from the host port and sends back the result, then exchanging
+// words with it from the simulated CPU. The CPU polls the host port status
+// between random instruction lengths, with a few different delays between
+// sending and receiving, and with the RREQ interrupt enabled (the DSP must
+// still run after every CPU instruction) and disabled. Every value the CPU
+// reads from the host port, and the DSP state at the end, must be the same
+// as without the option.
+//
+// usage: hatarib_bench_dsp [exchanges]
+
+#include "../hatari/src/includes/main.h"
+#include "../hatari/src/includes/mfp.h"
+#include "../hatari/src/falcon/dsp.h"
+#include "../hatari/src/falcon/dsp_cpu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+#define HOST_PORT   0xFFA200
+
+extern bool core_dsp_lazy; // core.c
+extern bool core_dsp_cache;
+extern uint32_t core_dsp_cache_hits;
+extern uint32_t core_dsp_cache_misses;
+extern uint32_t IoAccessBaseAddress; // ioMem.h needs the UAE CPU headers
+extern int nIoMemAccessSize;
+extern uint8_t STRam[]; // IO memory
+
+static long long bench_time_usec(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (long long)((c.QuadPart * 1000000) / f.QuadPart);
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return ((long long)tv.tv_sec * 1000000) + tv.tv_usec;
+#endif
+}
+
+static uint32_t rng = 12345;
+
+static uint32_t bench_rand(void)
+{
+	rng = rng * 1103515245 + 12345;
+	return rng >> 8;
+}
+
+//
+// simulated CPU
+//
+
+static uint64_t host_hash; // every byte read from the host port
+static uint64_t host_cycles;
+
+// one CPU instruction: the DSP runs after it, as in m68k_run
+static void cpu_step(int cycles)
+{
+	DSP_Run(cycles);
+	host_cycles += cycles;
+}
+
+// random instruction lengths of a polling loop
+static void cpu_random_step(void)
+{
+	cpu_step(4 + (int)(bench_rand() % 5) * 4);
+}
+
+static void host_read(uint32_t addr, int size, uint8_t* data)
+{
+	IoAccessBaseAddress = addr;
+	nIoMemAccessSize = size;
+	DSP_HandleReadAccess();
+	for (int i=0; i<size; ++i)
+	{
+		data[i] = STRam[addr+i];
+		host_hash = (host_hash ^ data[i]) * 0x100000001B3ULL;
+	}
+	cpu_random_step();
+}
+
+static void host_write(uint32_t addr, int size, const uint8_t* data)
+{
+	for (int i=0; i<size; ++i)
+		STRam[addr+i] = data[i];
+	IoAccessBaseAddress = addr;
+	nIoMemAccessSize = size;
+	DSP_HandleWriteAccess();
+	cpu_random_step();
+}
+
+static void host_write_word(uint32_t w)
+{
+	uint8_t b[3] = { (uint8_t)(w >> 16), (uint8_t)(w >> 8), (uint8_t)w };
+	host_write(HOST_PORT+CPU_HOST_TRXH,3,b);
+}
+
+static uint8_t host_status(void)
+{
+	uint8_t s;
+	host_read(HOST_PORT+CPU_HOST_ISR,1,&s);
+	return s;
+}
+
+// polls the status until a bit is set, false if the DSP never sets it
+static bool host_wait(int bit)
+{
+	for (int i=0; i<1000000; ++i)
+		if (host_status() & (1<<bit)) return true;
+	return false;
+}
+
+// resets the DSP and bootstraps a program into P:0, like the DSP_LoadProg XBIOS call
+static void host_bootstrap(const uint32_t* prog, int len)
+{
+	DSP_Reset();
+	memset(dsp_core.ramint,0,sizeof(dsp_core.ramint));
+	memset(dsp_core.ramext,0,sizeof(dsp_core.ramext));
+	for (int i=0; i<0x200; ++i)
+	{
+		if (!host_wait(CPU_HOST_ISR_TXDE)) return;
+		host_write_word((i < len) ? prog[i] : 0);
+	}
+}
+
+//
+// decode cache: self-modifying DSP program
+//
+
+// targets the program rewrites, and the P address it executes for each
+static const uint32_t SMC_TARGET[4]  = { 0x0080, 0x0180, 0x2000, 0x2100 }; // the last is X memory
+static const uint32_t SMC_EXECUTE[4] = { 0x0080, 0x0180, 0x2000, 0x6100 };
+
+#define SMC_ADD   0x200040 // add x0,a
+#define SMC_SUB   0x200044 // sub x0,a
+#define SMC_RTS   0x00000C
+
+static int smc_program(uint32_t* p)
+{
+	int n = 0;
+	p[n++] = 0x200013;                    // clr a
+	p[n++] = 0x44F400; p[n++] = 1;        // move #>1,x0
+	p[n++] = 0x47F400; p[n++] = SMC_ADD;  // move #>add,y1
+	p[n++] = 0x46F400; p[n++] = SMC_SUB;  // move #>sub,y0
+	p[n++] = 0x45F400; p[n++] = SMC_RTS;  // move #>rts,x1
+	for (int i=0; i<4; ++i)
+	{
+		const uint32_t t = SMC_TARGET[i];
+		const bool xmem = (i == 3);
+		// write add and rts, call it, rewrite add as sub, call it again: a adds 1 and subtracts 1
+		p[n++] = xmem ? 0x477000 : 0x077087; p[n++] = t;   // movem y1,p:t / move y1,x:t
+		p[n++] = xmem ? 0x457000 : 0x077085; p[n++] = t+1; // movem x1,p:t+1 / move x1,x:t+1
+		p[n++] = 0x0BF080; p[n++] = SMC_EXECUTE[i];        // jsr
+		p[n++] = xmem ? 0x467000 : 0x077086; p[n++] = t;   // movem y0,p:t / move y0,x:t
+		p[n++] = 0x0BF080; p[n++] = SMC_EXECUTE[i];        // jsr
+	}
+	p[n] = 0x0C0000 | n; ++n;             // jmp *
+	return n;
+}
+
+// returns the a accumulator at the end of the program, -1 if it didn't finish
+static int64_t run_smc(bool cache)
+{
+	uint32_t prog[64];
+	int len = smc_program(prog);
+	core_dsp_cache = cache;
+	core_dsp_lazy = false;
+	host_bootstrap(prog,len);
+	for (int i=0; i<10000; ++i)
+	{
+		if (dsp_core.pc == (len-1))
+			return
+				((int64_t)dsp_core.registers[DSP_REG_A2] << 48) |
+				((int64_t)dsp_core.registers[DSP_REG_A1] << 24) |
+				((int64_t)dsp_core.registers[DSP_REG_A0]);
+		dsp56k_execute_instruction();
+	}
+	return -1;
+}
+
+//
+// lazy catch-up: host port exchanges
+//
+
+static const uint32_t SUM_PROGRAM[] = {
+	0x0AA980, 0x000000, // 0: jclr #0,x:$ffe9,0   wait HRDF
+	0x44F000, 0x00FFEB, // 2: move x:$ffeb,x0
+	0x200013,           // 4: clr a
+	0x0664A0,           // 5: rep #100
+	0x200040,           // 6: add x0,a
+	0x0AA981, 0x000007, // 7: jclr #1,x:$ffe9,7   wait HTDE
+	0x567000, 0x00FFEB, // 9: move a,x:$ffeb
+	0x0C0000,           // 11: jmp 0
+};
+
+typedef struct
+{
+	uint64_t hash;
+	uint64_t cycles;
+	uint64_t dsp; // hash of the DSP state
+	int wrong; // sums not received as expected
+	long long usec;
+} EXCHANGE_RESULT;
+
+static EXCHANGE_RESULT run_exchange(int exchanges, int delay, bool rreq, bool lazy, bool cache)
+{
+	EXCHANGE_RESULT r;
+	r.wrong = 0;
+	rng = 12345 + delay;
+	host_hash = 0xCBF29CE484222325ULL;
+	host_cycles = 0;
+	core_dsp_lazy = lazy;
+	core_dsp_cache = cache;
+	host_bootstrap(SUM_PROGRAM,sizeof(SUM_PROGRAM)/sizeof(SUM_PROGRAM[0]));
+	if (rreq)
+	{
+		uint8_t icr = 1 << CPU_HOST_ICR_RREQ;
+		host_write(HOST_PORT+CPU_HOST_ICR,1,&icr);
+	}
+
+	long long t0 = bench_time_usec();
+	for (int i=0; i<exchanges; ++i)
+	{
+		uint8_t rx[3];
+		if (!host_wait(CPU_HOST_ISR_TXDE)) { r.wrong += exchanges - i; break; }
+		host_write_word((uint32_t)i & 0xFFFF);
+		for (int d=0; d<delay; ++d) cpu_step(10); // dbra
+		if (!host_wait(CPU_HOST_ISR_RXDF)) { r.wrong += exchanges - i; break; }
+		host_read(HOST_PORT+CPU_HOST_TRXH,3,rx);
+		if ((uint32_t)((rx[0] << 16) | (rx[1] << 8) | rx[2]) != ((uint32_t)i & 0xFFFF) * 100) ++r.wrong;
+	}
+	DSP_CatchUp(); // the end of frame
+	r.usec = bench_time_usec() - t0;
+
+	r.hash = host_hash;
+	r.cycles = host_cycles;
+	r.dsp = 0xCBF29CE484222325ULL;
+	for (size_t i=0; i<sizeof(dsp_core); ++i)
+		r.dsp = (r.dsp ^ ((const uint8_t*)&dsp_core)[i]) * 0x100000001B3ULL;
+	return r;
+}
+
+int main(int argc, char** argv)
+{
+	int exchanges = (argc > 1) ? atoi(argv[1]) : 20000;
+	int result = 0;
+
+	if (exchanges < 1) exchanges = 1;
+	MFP_Init(MFP_Array); // the host port interrupt updates the CPU interrupt level with the MFP's
+	DSP_Init();
+
+	// decode cache
+	{
+		int64_t a0 = run_smc(false);
+		core_dsp_cache_hits = core_dsp_cache_misses = 0;
+		int64_t a1 = run_smc(true);
+		bool ok = (a0 == 0) && (a1 == 0);
+		printf("rewritten instructions: cache off a=%lld, cache on a=%lld (%u hits, %u misses)%s\n",
+			(long long)a0, (long long)a1, core_dsp_cache_hits, core_dsp_cache_misses,
+			ok ? "" : "  MISMATCH");
+		if (!ok) result = 1;
+	}
+
+	// lazy catch-up
+	static const int DELAYS[3] = { 0, 7, 150 };
+	for (int rreq=0; rreq<2; ++rreq)
+	{
+		for (int d=0; d<3; ++d)
+		{
+			const int delay = DELAYS[d];
+			EXCHANGE_RESULT e[4]; // lazy off/on, cache off/on
+			for (int m=0; m<4; ++m)
+				e[m] = run_exchange(exchanges,delay,rreq!=0,(m & 1)!=0,(m & 2)!=0);
+			bool ok = true;
+			for (int m=0; m<4; ++m)
+				if (e[m].wrong || e[m].hash != e[0].hash || e[m].cycles != e[0].cycles || e[m].dsp != e[0].dsp) ok = false;
+			printf("RREQ %s delay %3d: %6.3f us/exchange, lazy %6.3f, cache %6.3f, both %6.3f%s\n",
+				rreq ? "on " : "off", delay,
+				(double)e[0].usec / (double)exchanges,
+				(double)e[1].usec / (double)exchanges,
+				(double)e[2].usec / (double)exchanges,
+				(double)e[3].usec / (double)exchanges,
+				ok ? "" : "  MISMATCH");
+			if (!ok) result = 1;
+		}
+	}
+	core_dsp_lazy = false;
+	core_dsp_cache = false;
+	return result;
+}
@@ -0,0 +1,250 @@
+// hatariB YM2149 synthesis micro-benchmark
+//
+// Plays pseudo-random YM2149 register streams through Hatari's sound
+// emulation (hatari/src/sound.c) with the original cycle by cycle 250 kHz
+// loop and with the block kernel (YM2149_Block_Kernel), checks that both
+// generate the same 250 kHz samples, and times both. See DEVELOP.md,
+// YM2149 Block Synthesis.
+//
+// Each stream writes a few registers at random times in every frame.
+// Tone, noise and envelope periods of 0 and 1, envelope shape restarts,
+// voices switched off in the mixer or at volume 0, and envelope volumes
+// are all covered. The "music" stream keeps noise off and changes notes
+// once per frame, like a typical tracker replay.
+//
+// A quiet stream is then resampled to 44.1, 48 and 96 kHz output, with the
+// default weighted average resampling and IIR lowpass filter chain, and with
+// the band-limited polyphase resampler (YM2149_LPF_FILTER_SINC), to time the
+// cost of each per output sample.
+//
+// usage: hatarib_bench_ym [frames]
+
+#include "../hatari/src/includes/main.h"
+#include "../hatari/src/includes/configuration.h"
+#include "../hatari/src/includes/clocks_timings.h"
+#include "../hatari/src/includes/sound.h"
+#include "../hatari/src/includes/audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+#define CYCLES_PER_FRAME   160256 // ST 50 Hz
+#define MAX_WRITES         16
+
+extern ymsample YM_Buffer_250[32768]; // sound.c
+extern bool core_audio_skip; // core.c
+
+static long long bench_time_usec(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (long long)((c.QuadPart * 1000000) / f.QuadPart);
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return ((long long)tv.tv_sec * 1000000) + tv.tv_usec;
+#endif
+}
+
+static uint32_t rng;
+
+static uint32_t bench_rand(void)
+{
+	rng = rng * 1103515245 + 12345;
+	return rng >> 8;
+}
+
+//
+// register streams
+//
+
+typedef struct
+{
+	int count;
+	int cycle[MAX_WRITES]; // sorted within the frame
+	uint8_t reg[MAX_WRITES];
+	uint8_t value[MAX_WRITES];
+} FRAME_WRITES;
+
+static FRAME_WRITES* stream;
+
+static uint8_t random_value(int reg, bool music)
+{
+	uint32_t r = bench_rand();
+	switch (reg)
+	{
+	case 0: case 2: case 4: // tone fine: often short periods
+		if (music) return (uint8_t)(r >> 4);
+		return (uint8_t)(((r & 3) == 0) ? (r >> 4) & 3 : (r >> 4));
+	case 1: case 3: case 5: // tone coarse: notes of about 120-490 Hz for music
+		if (music) return (uint8_t)(1 + ((r >> 4) % 3));
+		return (uint8_t)(((r & 3) == 0) ? 0 : (r >> 4) & 0x0f);
+	case 6: // noise
+		return (uint8_t)((r >> 4) & 0x1f);
+	case 7: // mixer
+		if (music) return (uint8_t)(0x38 | ((r >> 4) & 0x07)); // noise off
+		return (uint8_t)((r >> 4) & 0x3f);
+	case 8: case 9: case 10: // volume or envelope
+		if ((r & 7) == 0) return 0;
+		return (uint8_t)((r >> 4) & 0x1f);
+	case 11:
+		return (uint8_t)(r >> 4);
+	case 12: // envelope coarse: buzzer periods or slow envelopes
+		return (uint8_t)(((r & 1) == 0) ? 0 : (r >> 4) & 0x1f);
+	default: // 13 envelope shape
+		return (uint8_t)((r >> 4) & 0x0f);
+	}
+}
+
+static void make_stream(int frames, uint32_t seed, bool music)
+{
+	rng = seed;
+	for (int f=0; f<frames; ++f)
+	{
+		FRAME_WRITES* w = &stream[f];
+		static const int music_regs[7] = { 7, 0, 1, 2, 3, 8, 9 }; // two voices
+		w->count = music ? 7 : (int)(bench_rand() % MAX_WRITES);
+		int cycle = 0;
+		for (int i=0; i<w->count; ++i)
+		{
+			int reg;
+			if (music)
+			{
+				reg = music_regs[i];
+				cycle += 64 + (int)(bench_rand() % 64); // writes together at the start of the frame
+			}
+			else
+			{
+				reg = (int)(bench_rand() % 14);
+				cycle += (int)(bench_rand() % (CYCLES_PER_FRAME / MAX_WRITES));
+			}
+			w->cycle[i] = cycle;
+			w->reg[i] = (uint8_t)reg;
+			w->value[i] = random_value(reg,music);
+			if (music && reg >= 8) w->value[i] &= 0x0f; // no envelope
+		}
+	}
+}
+
+// voices off and the longest periods: almost no synthesis time, to time the resampling
+static void make_quiet_stream(int frames)
+{
+	static const uint8_t quiet_regs[14] = { 0xff, 0x0f, 0xff, 0x0f, 0xff, 0x0f, 0x1f, 0x3f, 0, 0, 0, 0xff, 0xff, 0 };
+	for (int f=0; f<frames; ++f)
+		stream[f].count = 0;
+	stream[0].count = 14;
+	for (int i=0; i<14; ++i)
+	{
+		stream[0].cycle[i] = i;
+		stream[0].reg[i] = (uint8_t)i;
+		stream[0].value[i] = quiet_regs[i];
+	}
+}
+
+//
+// playback
+//
+
+static uint64_t play(int frames, bool block, bool check)
+{
+	uint64_t hash = 0;
+	uint64_t clock = 0;
+	YM2149_Block_Kernel = block;
+	Sound_Init(); // also resets the 250 kHz clock and buffer
+	for (int f=0; f<frames; ++f)
+	{
+		const FRAME_WRITES* w = &stream[f];
+		for (int i=0; i<w->count; ++i)
+		{
+			Sound_Update(clock + w->cycle[i]);
+			Sound_WriteReg(w->reg[i], w->value[i]);
+		}
+		clock += CYCLES_PER_FRAME;
+		Sound_Update(clock);
+		// a frame is about 5000 samples, so every sample is in the ring buffer for several frames
+		if (check)
+		{
+			for (int i=0; i<32768; ++i)
+				hash = (hash * 31) + (uint16_t)YM_Buffer_250[i];
+		}
+	}
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = (argc > 1) ? atoi(argv[1]) : 3000;
+	int result = 0;
+
+	if (frames < 1) frames = 1;
+	stream = malloc(sizeof(FRAME_WRITES) * frames);
+	if (!stream)
+	{
+		printf("Out of memory.\n");
+		return 1;
+	}
+
+	ConfigureParams.System.nMachineType = MACHINE_ST;
+	ClocksTimings_InitMachine(MACHINE_ST);
+	ClocksTimings_UpdateCpuFreqEmul(MACHINE_ST, 0);
+	core_audio_skip = true; // only time the 250 kHz synthesis, not the resampling to the output rate
+
+	static const char* names[] = { "music", "random 1", "random 2", "random 3" };
+	for (int s=0; s<4; ++s)
+	{
+		make_stream(frames, (uint32_t)(s+1), s == 0);
+		uint64_t h_ref = play(frames,false,true);
+		uint64_t h_block = play(frames,true,true);
+		long long t0 = bench_time_usec();
+		play(frames,false,false);
+		long long t1 = bench_time_usec();
+		play(frames,true,false);
+		long long t2 = bench_time_usec();
+		printf("%-9s cycle loop %7.2f us/frame, block %7.2f us/frame%s\n",
+			names[s],
+			(double)(t1-t0) / (double)frames,
+			(double)(t2-t1) / (double)frames,
+			(h_ref == h_block) ? "" : "  MISMATCH");
+		if (h_ref != h_block) result = 1;
+	}
+
+	// resampling to the output rate, the time with core_audio_skip (synthesis only) is subtracted
+	make_quiet_stream(frames);
+	YM2149_HPF_Filter = YM2149_HPF_FILTER_NONE;
+	static const int rates[] = { 44100, 48000, 96000 };
+	for (int r=0; r<3; ++r)
+	{
+		nAudioFrequency = rates[r];
+		long long t[3] = { 0, 0, 0 };
+		for (int rep=0; rep<5; ++rep) // best of 5, the difference is small compared to the synthesis time
+		{
+			for (int m=0; m<3; ++m)
+			{
+				static const int lpf[3] = { YM2149_LPF_FILTER_NONE, YM2149_LPF_FILTER_IIR, YM2149_LPF_FILTER_SINC };
+				YM2149_LPF_Filter = lpf[m];
+				core_audio_skip = (m == 0);
+				long long t0 = bench_time_usec();
+				play(frames,true,false);
+				long long tp = bench_time_usec() - t0;
+				if (rep == 0 || tp < t[m]) t[m] = tp;
+			}
+		}
+		double samples = (double)frames * (double)rates[r] * CYCLES_PER_FRAME / 8010613.0; // ST CPU clock
+		printf("%5d Hz   average + IIR %6.2f ns/sample, band-limited %6.2f ns/sample\n",
+			rates[r],
+			(double)(t[1]-t[0]) * 1000.0 / samples,
+			(double)(t[2]-t[0]) * 1000.0 / samples);
+	}
+	core_audio_skip = true;
+
+	YM2149_Block_Kernel = true;
+	free(stream);
+	return result;
+}
@@ -12,6 +12,9 @@
 #define VIDEO_MAX_PITCH   (VIDEO_MAX_W*4)
 // 4 frames of buffer at slowest framerate
 #define AUDIO_BUFFER_LEN   (4*2*96000/50)
+// audio_batch_cb calls per frame: contiguous pieces of AudioMixBuffer, 2 when it wraps
+// (any further piece, e.g. if Hatari resets its write position, is copied after the last one in core_audio_buffer)
+#define AUDIO_SPANS        2
 
 // Header size must accomodate core data before the hatari memory snapshot
 // the base savesate for a 1MB ST is about 3.5MB
@@ -24,7 +27,7 @@
 #define SNAPSHOT_MINIMUM       (8 * 1024 * 1024)
 #define SNAPSHOT_OVERHEAD      (1 * 1024 * 1024)
 #define SNAPSHOT_ROUND         (64 * 1024)
-#define SNAPSHOT_VERSION       2
+#define SNAPSHOT_VERSION       6
 
 // Logs seem valid for either first retro_set_environment or everything else,
 // set this to 1 when you want to log the first call to retro_set_environment.
@@ -104,6 +107,7 @@ extern int core_save_state(void);
 extern int core_restore_state(void);
 extern void Statusbar_SetMessage(const char *msg); // statusbar.c
 extern void core_statusbar_update(void);
+extern void core_screen_convert_wait(void); // screen.c
 
 //
 // Available to Hatari
@@ -118,8 +122,23 @@ bool core_option_soft_reset = false;
 bool core_show_welcome = true;
 bool core_boot_alert = true;
 bool core_first_reset = true;
-bool core_perf_display = false;
+int core_perf_display = 0;
 bool core_midi_enable = true;
+bool core_savestate_refs = false;
+bool core_video_thread = false;
+int core_frameskip = 0;
+int core_frameskip_threshold = 33;
+bool core_turbo = true;
+bool core_idle_skip = true;
+uint64_t core_idle_skip_cycles = 0;
+#if CORE_PREDECODE_TEST
+uint64_t core_predecode_hits = 0;
+uint64_t core_predecode_misses = 0;
+#endif
+bool core_dsp_lazy = false;
+bool core_dsp_cache = false;
+uint32_t core_dsp_cache_hits = 0;
+uint32_t core_dsp_cache_misses = 0;
 
 //
 // Core internal variables
@@ -130,8 +149,11 @@ bool content_override_set = false;
 uint32_t blank_screen[320*200] = { 0 }; // safety buffer in case frame was never been provided
 
 void* core_video_buffer = blank_screen;
-int16_t core_audio_buffer[AUDIO_BUFFER_LEN];
+int16_t core_audio_buffer[AUDIO_BUFFER_LEN]; // hold samples for pause, or pieces that didn't fit in AUDIO_SPANS
 int16_t core_audio_last[2] = { 0, 0 };
+const int16_t* core_audio_span_data[AUDIO_SPANS];
+int core_audio_span_len[AUDIO_SPANS]; // stereo samples
+int core_audio_spans = 0;
 double core_audio_hold_remain = 0;
 int core_video_w = 320;
 int core_video_h = 200;
@@ -148,6 +170,17 @@ int core_audio_samples_pending = 0;
 bool core_video_changed = false;
 bool core_rate_changed = false;
 bool core_statusbar_restore = false;
+bool core_video_skip = false;
+bool core_audio_skip = false;
+bool core_audio_turbo = false;
+bool core_video_threaded = false; // frame conversion on the worker thread, shown one frame late
+bool core_video_can_dupe = false; // frontend accepts NULL video_cb to repeat the last frame
+static bool core_video_dirty = true; // core_video_buffer has changed since the last visible video_cb
+// In-core rewind only keeps the real frames:
+// with same-instance run-ahead, the frames run after its savestate are speculative until it is restored.
+// A secondary run-ahead instance only runs speculative frames, and netplay rollback can't be rewound.
+static bool core_frame_speculative = false;
+static bool core_rewind_blocked = false;
 // fps and samplerate update a "new" variable,
 // which is later transferred to the actual variable.
 // This is because they can sometimes be updated multiple times
@@ -226,6 +259,69 @@ void core_debug_bin(const char* data, int len, int offset) // hex dump to debug
 	}
 }
 
+// frameskip
+// A skipped frame is emulated fully, including sound, but its video is not converted (as for core_video_skip),
+// and the frontend repeats the last frame.
+
+#define FRAMESKIP_MAX   6 // most consecutive frames skipped by auto/aggressive
+
+static int core_frameskip_last = -1;
+static int core_frameskip_fps_last = 0;
+static bool core_frameskip_status = false; // frontend is reporting its audio buffer status
+static bool core_frameskip_frame = false; // this frame is skipped
+static int core_frameskip_count = 0; // consecutive skipped frames
+static bool core_audio_buffer_active = false;
+static unsigned core_audio_buffer_occupancy = 100;
+static bool core_audio_buffer_underrun = false;
+
+static void RETRO_CALLCONV core_audio_buffer_status(bool active, unsigned occupancy, bool underrun_likely)
+{
+	// called by the frontend before each retro_run
+	core_audio_buffer_active = active;
+	core_audio_buffer_occupancy = occupancy;
+	core_audio_buffer_underrun = underrun_likely;
+}
+
+static void core_frameskip_update(void)
+{
+	if (core_frameskip == core_frameskip_last && core_video_fps == core_frameskip_fps_last) return;
+	bool status = (core_frameskip == 1 || core_frameskip == 2);
+	bool status_last = (core_frameskip_last == 1 || core_frameskip_last == 2);
+	if (status != status_last || core_frameskip_last < 0)
+	{
+		struct retro_audio_buffer_status_callback cb = { core_audio_buffer_status };
+		core_frameskip_status = environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, status ? &cb : NULL) && status;
+		if (status && !core_frameskip_status)
+			core_info_printf("Frontend does not report audio buffer status, automatic frameskip is unavailable.\n");
+		core_audio_buffer_active = false;
+	}
+	// a longer audio buffer gives automatic frameskip time to catch up: 6 frames, rounded up to 32 ms
+	unsigned latency = 0;
+	if (core_frameskip_status)
+	{
+		latency = (unsigned)((6000.0 / (double)core_video_fps) + 0.5);
+		latency = ((latency + 31) / 32) * 32;
+	}
+	if (core_frameskip_status || status_last)
+		environ_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &latency);
+	core_frameskip_last = core_frameskip;
+	core_frameskip_fps_last = core_video_fps;
+	core_frameskip_count = 0;
+}
+
+static bool core_frameskip_check(void)
+{
+	bool skip = false;
+	if (core_frameskip == 1)
+		skip = core_frameskip_status && core_audio_buffer_active && core_audio_buffer_underrun && (core_frameskip_count < FRAMESKIP_MAX);
+	else if (core_frameskip == 2)
+		skip = core_frameskip_status && core_audio_buffer_active && ((int)core_audio_buffer_occupancy < core_frameskip_threshold) && (core_frameskip_count < FRAMESKIP_MAX);
+	else if (core_frameskip >= 3)
+		skip = core_frameskip_count < (core_frameskip - 2);
+	core_frameskip_count = skip ? (core_frameskip_count + 1) : 0;
+	return skip;
+}
+
 // debug CPU tracing
 #if CORE_DEBUG
 int core_tracing = 0;
@@ -298,6 +394,7 @@ void core_video_update(void* data, int w, int h, int pitch, int resolution)
 	if (h > VIDEO_MAX_H) w = VIDEO_MAX_H;
 	if (pitch > VIDEO_MAX_PITCH) w = VIDEO_MAX_PITCH;
 	core_video_buffer = data;
+	core_video_dirty = true;
 	if (w != core_video_w) { core_video_w = w; core_video_changed = true; }
 	if (h != core_video_h) { core_video_h = h; core_video_changed = true; }
 	core_video_pitch = pitch;
@@ -309,45 +406,86 @@ void core_video_update(void* data, int w, int h, int pitch, int resolution)
 	}
 }
 
-void core_audio_update(const int16_t data[][2], int index, int length)
+static int core_audio_span_limit(int length)
 {
-	int pos = core_audio_samples_pending;
 	int len = length * 2;
-	int max = AUDIO_BUFFER_LEN - pos;
+	int max = AUDIO_BUFFER_LEN - core_audio_samples_pending;
 	if (len > max) len = max;
-	core_audio_samples_pending += len;
-	int l2 = len / 2;
-	for (int i=0; i<l2; ++i)
+	return len / 2;
+}
+
+static int16_t* core_audio_append(int l2)
+{
+	// extend the last span with l2 samples written to core_audio_buffer (l2 from core_audio_span_limit)
+	int last = core_audio_spans - 1;
+	int16_t* base = core_audio_buffer; // after an earlier span already in core_audio_buffer
+	if (last > 0 && core_audio_span_data[0] == core_audio_buffer)
+		base += core_audio_span_len[0] * 2;
+	if (last < 0 || (core_audio_span_data[last] != base && core_audio_spans < AUDIO_SPANS))
 	{
-		core_audio_buffer[pos+0] = data[index+i][0];
-		core_audio_buffer[pos+1] = data[index+i][1];
-		pos += 2;
+		core_audio_span_data[core_audio_spans] = base;
+		core_audio_span_len[core_audio_spans] = 0;
+		last = core_audio_spans++;
 	}
-	// save last sample in case hold is needed
-	if (l2 > 0)
+	else if (core_audio_span_data[last] != base)
+	{
+		memmove(base, core_audio_span_data[last], core_audio_span_len[last] * 2 * sizeof(int16_t));
+		core_audio_span_data[last] = base;
+	}
+	int16_t* dst = base + (core_audio_span_len[last] * 2);
+	core_audio_span_len[last] += l2;
+	core_audio_samples_pending += l2 * 2;
+	return dst;
+}
+
+static void core_audio_span(const int16_t* data, int length)
+{
+	// extend the last span if contiguous, otherwise start a new one, or copy it if there are no spans left
+	int l2 = core_audio_span_limit(length);
+	if (l2 <= 0) return;
+	if (core_audio_spans > 0 && (core_audio_span_data[core_audio_spans-1] + (core_audio_span_len[core_audio_spans-1] * 2)) == data)
+		core_audio_span_len[core_audio_spans-1] += l2;
+	else if (core_audio_spans < AUDIO_SPANS)
+	{
+		core_audio_span_data[core_audio_spans] = data;
+		core_audio_span_len[core_audio_spans] = l2;
+		++core_audio_spans;
+	}
+	else
 	{
-		core_audio_last[0] = data[index+l2-1][0];
-		core_audio_last[1] = data[index+l2-1][1];
+		memcpy(core_audio_append(l2), data, l2 * 2 * sizeof(int16_t));
+		return;
 	}
+	core_audio_samples_pending += l2 * 2;
+}
+
+void core_audio_update(const int16_t data[][2], int index, int length)
+{
+	if (core_audio_skip) return; // discarded, and core_audio_last should only hold audible samples
+	// AudioMixBuffer is sent directly at the end of the frame,
+	// it holds several frames of samples so this frame's won't be overwritten before then
+	core_audio_span(data[index], length);
 }
 
 static void core_audio_hold(int length)
 {
 	// generate hold samples to fill a pause
-	int pos = core_audio_samples_pending;
-	int len = length * 2;
-	int max = AUDIO_BUFFER_LEN - pos;
-	if (len > max) len = max;
-	core_audio_samples_pending += len;
-	int l2 = len / 2;
+	int l2 = core_audio_span_limit(length);
+	if (l2 <= 0) return;
+	int16_t* dst = core_audio_append(l2);
 	for (int i=0; i<l2; ++i)
 	{
-		core_audio_buffer[pos+0] = core_audio_last[0];
-		core_audio_buffer[pos+1] = core_audio_last[1];
-		pos += 2;
+		dst[(i*2)+0] = core_audio_last[0];
+		dst[(i*2)+1] = core_audio_last[1];
 	}
 }
 
+static void core_audio_discard(void)
+{
+	core_audio_samples_pending = 0;
+	core_audio_spans = 0;
+}
+
 void core_set_fps(int rate)
 {
 	//core_debug_printf("core_set_fps(%d)\n",rate);
@@ -387,7 +525,7 @@ int core_reset_colder(void) // user-initiated cold reset (stronger than Reset_Co
 	Reset_Cold();
 	core_m68k_reinit(true); // restart emulation
 	m68k_go_frame(true); // run one frame
-	core_audio_samples_pending = 0; // delete audio generated by the frame
+	core_audio_discard(); // delete audio generated by the frame
 	return Reset_Cold(); // reset again
 }
 
@@ -561,9 +699,18 @@ enum {
 };
 static retro_time_t perf_counter_start[PERF_COUNT] = { 0 };
 static retro_time_t perf_counter_total[PERF_COUNT] = { 0 };
+static uint32_t perf_serialize_copied = 0; // RAM bytes copied by the last serialize
 #define PERF_START(p_) { if (retro_perf) perf_counter_start[p_] = retro_perf->get_time_usec(); }
 #define PERF_STOP(p_)  { if (retro_perf) perf_counter_total[p_] += (retro_perf->get_time_usec() - perf_counter_start[p_]); }
 
+void core_perf_totals(retro_time_t* run, retro_time_t* run_reset, retro_time_t* serialize, retro_time_t* unserialize)
+{
+	*run = perf_counter_total[PERF_RUN];
+	*run_reset = perf_counter_total[PERF_RUN_RESET];
+	*serialize = perf_counter_total[PERF_SERIALIZE];
+	*unserialize = perf_counter_total[PERF_UNSERIALIZE];
+}
+
 static void core_perf_set_environment(retro_environment_t cb)
 {
 	static struct retro_perf_callback retro_perf_interface;
@@ -621,13 +768,28 @@ static void core_perf_show()
 	avg /= PERF_RUN_AVG;
 
 	// display on the statusbar
-	char msg[60];
-	snprintf(msg, sizeof(msg), "Perf: %6d (%6d) Bt %6d Sv %6d Rs %6d",
-		perf_time[PERF_RUN], avg,
-		perf_time[PERF_RUN_RESET],
-		perf_time[PERF_SERIALIZE],
-		perf_time[PERF_UNSERIALIZE]
-	);
+	char msg[80];
+	if (core_perf_display == 2) // DSP decode cache: instructions this frame, % found in the cache
+	{
+		uint32_t total = core_dsp_cache_hits + core_dsp_cache_misses;
+		snprintf(msg, sizeof(msg), "Perf: %6d (%6d) DSP cache %8u ins %3d%% hit",
+			perf_time[PERF_RUN], avg,
+			(unsigned int)total,
+			(int)(total ? (((uint64_t)core_dsp_cache_hits * 100) / total) : 0)
+		);
+		core_dsp_cache_hits = 0;
+		core_dsp_cache_misses = 0;
+	}
+	else
+	{
+		snprintf(msg, sizeof(msg), "Perf: %6d (%6d) Bt %6d Sv %6d Rs %6d Cp %5dK",
+			perf_time[PERF_RUN], avg,
+			perf_time[PERF_RUN_RESET],
+			perf_time[PERF_SERIALIZE],
+			perf_time[PERF_UNSERIALIZE],
+			(int)((perf_serialize_copied + 1023) / 1024)
+		);
+	}
 	Statusbar_SetMessage(msg);
 }
 
@@ -809,12 +971,109 @@ void core_serialize_uint32(uint32_t *x) { core_serialize_internal(x,sizeof(uint3
 void core_serialize_data(void* d, size_t size) { core_serialize_internal(d,size); }
 void core_serialize_skip(size_t size) { core_snapshot_skip(size); }
 
+// Incremental RAM savestate:
+// If the RAM was last saved to or restored from this same buffer,
+// only the pages marked dirty since then need to be copied.
+// The frontend must promise not to modify the buffer between calls,
+// so this is only enabled for run-ahead within the same instance.
+static bool snapshot_incremental = false;
+static const uint8_t* snapshot_ram_buffer = NULL; // buffer that matches RAM except for dirty pages
+static int snapshot_ram_pos = 0;
+static uint32_t snapshot_ram_size = 0;
+static uint32_t snapshot_ram_copied = 0; // bytes copied during the current serialize
+
+void core_snapshot_ram(uint8_t* ram, uint32_t size, uint8_t* dirty, uint32_t page)
+{
+	uint32_t pages = (size + page - 1) / page;
+	if (snapshot_incremental &&
+		snapshot_buffer != NULL &&
+		snapshot_buffer == snapshot_ram_buffer &&
+		snapshot_pos == snapshot_ram_pos &&
+		size == snapshot_ram_size &&
+		(snapshot_pos + size) <= snapshot_size)
+	{
+		uint8_t* s = snapshot_buffer + snapshot_pos;
+		for (uint32_t i=0; i<pages; ++i)
+		{
+			if (!dirty[i]) continue;
+			uint32_t o = i * page;
+			uint32_t len = ((size - o) < page) ? (size - o) : page;
+			if (core_serialize_write) memcpy(s+o,ram+o,len);
+			else                      memcpy(ram+o,s+o,len);
+			snapshot_ram_copied += len;
+		}
+		core_snapshot_skip(size);
+	}
+	else if (!snapshot_incremental)
+	{
+		// other savestates (normal, rewind) are a full copy that leaves the incremental buffer alone:
+		// saving doesn't change RAM, so its dirty pages still say what differs from that buffer,
+		// but restoring replaces RAM, so the next incremental savestate must copy all of it
+		if (core_serialize_write) core_snapshot_write((const char*)ram,size);
+		else                      core_snapshot_read((char*)ram,size);
+		if (!core_serialize_write || snapshot_buffer == snapshot_ram_buffer)
+			snapshot_ram_buffer = NULL;
+		snapshot_ram_copied += size;
+		return;
+	}
+	else
+	{
+		snapshot_ram_pos = snapshot_pos;
+		if (core_serialize_write) core_snapshot_write((const char*)ram,size);
+		else                      core_snapshot_read((char*)ram,size);
+		snapshot_ram_copied += size;
+	}
+	// RAM now matches this buffer
+	memset(dirty,0,pages);
+	if (snapshot_buffer != NULL && !snapshot_error)
+	{
+		snapshot_ram_buffer = snapshot_buffer;
+		snapshot_ram_size = size;
+	}
+	else
+	{
+		snapshot_ram_buffer = NULL;
+	}
+}
+
+// Content references:
+// Data that can be recovered from outside the savestate (ROM, unmodified floppy images)
+// can be stored as a hash instead, verified on restore.
+// Always used for run-ahead and netplay, optional for normal savestates
+// because a reference can't be restored if its source has changed since.
+bool core_snapshot_refs = false;
+
+// Lean savestates:
+// Run-ahead and netplay rollback restore a recent state many times per second.
+// They leave out anything that can't change in that short time (ROM, OSK pause screen),
+// and skip restore work that only matters for a long term savestate.
+bool core_snapshot_lean = false;
+bool core_snapshot_same_instance = false;
+
+uint64_t core_hash(const void* data, size_t size)
+{
+	// FNV-1a over 64-bit words, with the high bits folded down so every bit affects the result
+	const uint8_t* d = (const uint8_t*)data;
+	uint64_t h = 0xCBF29CE484222325ULL ^ (uint64_t)size;
+	for (; size >= 8; size -= 8, d += 8)
+	{
+		uint64_t w;
+		memcpy(&w,d,8);
+		h = (h ^ w) * 0x00000100000001B3ULL;
+		h ^= h >> 32;
+	}
+	for (; size > 0; --size, ++d)
+		h = (h ^ *d) * 0x00000100000001B3ULL;
+	return h;
+}
+
 static bool core_serialize(bool write)
 {
 	uint8_t bval;
 	int32_t result = 0;
 	core_serialize_write = write;
 	core_snapshot_open_internal();
+	snapshot_ram_copied = 0;
 
 	// header (core data)
 	#if DEBUG_SAVESTATE
@@ -867,18 +1126,17 @@ static bool core_serialize(bool write)
 	// hatari state
 	result = 0;
 	if (write) result = core_save_state();
-	else       result = core_restore_state();
-
-	if (write)
+	else
 	{
-		// zero fill the remaining space
-		if (snapshot_buffer && snapshot_max < snapshot_size)
-			memset(snapshot_buffer + snapshot_max, 0, snapshot_size - snapshot_max);
+		core_screen_convert_wait();
+		result = core_restore_state();
 	}
-	else
+
+	if (!write)
 	{
 		// update core_disk to match changes to the inserted disks
-		core_disk_reindex();
+		// (lean restores return to a recent state that has the same disks)
+		if (!core_snapshot_lean) core_disk_reindex();
 		// cancel spurious rate changes after restore
 		core_rate_changed = false;
 		core_video_fps_new = core_video_fps;
@@ -889,7 +1147,7 @@ static bool core_serialize(bool write)
 	#if DEBUG_SAVESTATE
 		core_debug_snapshot("core_osk_screen");
 	#endif
-	core_osk_serialize_screen();
+	if (!core_snapshot_lean) core_osk_serialize_screen(); // lean restore keeps the current pause screen
 
 	// finish
 	#if DEBUG_SAVESTATE
@@ -956,6 +1214,7 @@ void core_config_update(bool force)
 		if (!environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE,&force) || !force) return;
 	}
 	core_info_printf("Applying configuration update.\n");
+	core_screen_convert_wait();
 	core_config_apply();
 }
 
@@ -1076,6 +1335,10 @@ RETRO_API void retro_init(void)
 			core_info_printf("Pixel format: %s\n",PIXEL_FORMAT_NAMES[core_pixel_format]);
 	}
 
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &core_video_can_dupe))
+		core_video_can_dupe = false;
+	core_video_dirty = true;
+
 	// initialize other modules
 	core_input_init();
 	core_disk_init();
@@ -1099,6 +1362,10 @@ RETRO_API void retro_init(void)
 	core_audio_last[0] = 0;
 	core_audio_last[1] = 0;
 
+	core_frameskip_last = -1; // frameskip callbacks are set on the first retro_run
+	core_frame_speculative = false;
+	core_rewind_blocked = false;
+
 	core_rand_seed = 1;
 }
 
@@ -1226,12 +1493,21 @@ RETRO_API void retro_run(void)
 		}
 	#endif
 
+	// hidden frames (e.g. run-ahead) will have their video/audio discarded
+	{
+		int av_enable = 3;
+		if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable)) av_enable = 3;
+		core_video_skip = !(av_enable & 1);
+		core_audio_skip = !(av_enable & 2);
+	}
+
 	// undo overlay
 	//   would have done this directly after video_cb,
 	//   but RetroArch seems to display what is given at video_cb time only when running,
 	//   but when in menus or paused (p) it displays the contents of the buffer at exit of retro_run instead?
 	if (core_runflags & CORE_RUNFLAG_OSK || core_osk_screen_restore)
 	{
+		core_video_dirty = true;
 		core_osk_restore(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
 	}
 
@@ -1254,6 +1530,40 @@ RETRO_API void retro_run(void)
 		core_runflags &= ~(CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_OSK);
 	}
 
+	// frameskip: only visible running frames are counted
+	core_frameskip_update();
+	core_frameskip_frame = false;
+	if (core_frameskip && !core_video_skip && !(core_runflags & (CORE_RUNFLAG_OSK | CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_RESET)))
+	{
+		core_frameskip_frame = core_frameskip_check();
+		if (core_frameskip_frame) core_video_skip = true;
+	}
+
+	// fast-forward turbo: while the frontend runs faster than real time, convert video only about as often as
+	// it could be displayed (the others are sent as dupes), and use unfiltered audio
+	core_audio_turbo = false;
+	if (core_turbo)
+	{
+		struct retro_throttle_state throttle;
+		if (environ_cb(RETRO_ENVIRONMENT_GET_THROTTLE_STATE, &throttle))
+			core_audio_turbo = (throttle.mode == RETRO_THROTTLE_FAST_FORWARD || throttle.mode == RETRO_THROTTLE_UNBLOCKED);
+	}
+	if (core_audio_turbo && retro_perf && !core_video_skip && !(core_runflags & (CORE_RUNFLAG_OSK | CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_RESET)))
+	{
+		static retro_time_t turbo_video_time = 0;
+		retro_time_t t = retro_perf->get_time_usec();
+		if ((t - turbo_video_time) >= (1000000 / core_video_fps))
+			turbo_video_time = t;
+		else
+		{
+			core_frameskip_frame = true;
+			core_video_skip = true;
+		}
+	}
+
+	// threaded conversion only for visible running frames, the overlay is drawn to the same surface
+	core_video_threaded = core_video_thread && !core_video_skip && !(core_runflags & (CORE_RUNFLAG_OSK | CORE_RUNFLAG_HALT));
+
 	// process CPU reset by restarting the loop and UAE
 	// can still happen while paused, as no CPU cycles are executed here, but screen dimensions etc. can be updated,
 	// though this will result in a black screen until unpaused and allowed to render
@@ -1275,6 +1585,12 @@ RETRO_API void retro_run(void)
 		PERF_STOP(PERF_RUN_RESET);
 	}
 
+	// in-core rewind steps back one frame before running it (only on real frames, not run-ahead's speculative ones)
+	bool rewind_frame = !core_frame_speculative && !core_rewind_blocked && !(core_runflags & (CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE));
+	bool rewinding = core_rewind_held && rewind_frame;
+	if (rewinding)
+		rewinding = core_rewind_step();
+
 	// force hatari to process the input queue before each frame starts
 	core_input_post();
 
@@ -1296,6 +1612,10 @@ RETRO_API void retro_run(void)
 		}
 	}
 
+	// finish a threaded frame conversion if the next one won't, or the statusbar needs redraw
+	if (!core_video_threaded || core_statusbar_restore)
+		core_screen_convert_wait();
+
 	// update video nature
 	if (core_rate_changed)
 	{
@@ -1305,6 +1625,7 @@ RETRO_API void retro_run(void)
 		environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &info);
 		core_rate_changed = false;
 		core_video_changed = false;
+		core_video_dirty = true;
 	}
 	else if (core_video_changed)
 	{
@@ -1313,19 +1634,27 @@ RETRO_API void retro_run(void)
 		retro_get_system_av_info(&info);
 		environ_cb(RETRO_ENVIRONMENT_SET_GEOMETRY, &info);
 		core_video_changed = false;
+		core_video_dirty = true;
 	}
 
-	// statusbar may need to be redrawn
-	if (core_statusbar_restore)
+	// statusbar may need to be redrawn (deferred until a visible frame)
+	if (core_statusbar_restore && !core_video_skip)
 	{
 		core_statusbar_update();
 		core_statusbar_restore = false;
+		core_video_dirty = true;
 	}
 
 	// draw overlay
 	if (core_runflags & CORE_RUNFLAG_OSK)
 	{
-		core_osk_render(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		if (!core_video_skip)
+		{
+			core_osk_render(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+			core_video_dirty = true;
+		}
+		else
+			core_osk_begin = 0; // savestated, must advance the same as a rendered frame
 	}
 
 	// performance counters (video_cb may block, so we don't want to include it in our performance measure)
@@ -1333,10 +1662,22 @@ RETRO_API void retro_run(void)
 	if (core_perf_display) core_perf_show();
 
 	// send video
-	video_cb(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+	// Hatari only writes to the screen through conversion, statusbar or GUI updates which end in core_video_update,
+	// so if none happened since the last visible frame the frontend can repeat it (dupe) instead of uploading it again.
+	// (Savestates do not contain the screen, so a restore does not change it either.)
+	// A frameskipped frame is also sent as a dupe, its new image (if any) is shown by the next frame that isn't skipped.
+	if (core_video_can_dupe && ((!core_video_dirty && !core_video_skip) || core_frameskip_frame))
+	{
+		video_cb(NULL,core_video_w,core_video_h,core_video_pitch);
+	}
+	else
+	{
+		video_cb(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		if (!core_video_skip) core_video_dirty = false;
+	}
 
 	// fill audio if pause
-	if (core_runflags & (CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_HALT))
+	if ((core_runflags & (CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_HALT)) && !core_audio_skip)
 	{
 		// how many new samples should we need?
 		// use floating point to allow fractionals
@@ -1351,15 +1692,19 @@ RETRO_API void retro_run(void)
 	}
 
 	// send audio
-	if (core_audio_samples_pending > 0)
+	for (int i=0; i<core_audio_spans; ++i)
 	{
-		unsigned int len = core_audio_samples_pending;
-		if (len > AUDIO_BUFFER_LEN) len = AUDIO_BUFFER_LEN;
-		audio_batch_cb(core_audio_buffer, len/2);
-		//core_debug_printf("audio_batch_cb(%p,%d)\n",core_audio_buffer,len/2);
-		core_audio_samples_pending = 0;
-		//core_debug_printf("audio send: %d\n",len/2);
+		audio_batch_cb(core_audio_span_data[i], core_audio_span_len[i]);
+		//core_debug_printf("audio_batch_cb(%p,%d)\n",core_audio_span_data[i],core_audio_span_len[i]);
 	}
+	if (core_audio_spans > 0)
+	{
+		// save last sample in case hold is needed
+		const int16_t* last = core_audio_span_data[core_audio_spans-1] + ((core_audio_span_len[core_audio_spans-1] - 1) * 2);
+		core_audio_last[0] = last[0];
+		core_audio_last[1] = last[1];
+	}
+	core_audio_discard();
 
 	// event queue end of frame
 	core_input_finish();
@@ -1367,6 +1712,10 @@ RETRO_API void retro_run(void)
 	// flush midi if needed
 	core_midi_frame();
 
+	// in-core rewind history
+	if (!rewinding && rewind_frame)
+		core_rewind_capture();
+
 #if DEBUG_SAVESTATE_DUMP
 	// write a savestate dump each frame
 	snapshot_buffer_prepare(snapshot_size,NULL);
@@ -1495,14 +1844,36 @@ RETRO_API size_t retro_serialize_size(void)
 	return snapshot_size;
 }
 
+static int core_savestate_context(void)
+{
+	int context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &context))
+		context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+	// run-ahead in the same instance keeps its savestate buffer intact between calls
+	snapshot_incremental = (context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE);
+	core_snapshot_same_instance = snapshot_incremental;
+	// states that won't outlive this session can refer to content instead of storing it
+	core_snapshot_refs = core_savestate_refs || (context != RETRO_SAVESTATE_CONTEXT_NORMAL);
+	core_snapshot_lean =
+		(context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE) ||
+		(context == RETRO_SAVESTATE_CONTEXT_ROLLBACK_NETPLAY);
+	return context;
+}
+
 RETRO_API bool retro_serialize(void *data, size_t size)
 {
 	bool result = false;
 	PERF_START(PERF_SERIALIZE);
 	//core_debug_printf("retro_serialize(%p,%d)\n",data,size);
 	snapshot_buffer_prepare(size,data);
+	int context = core_savestate_context();
 	if (core_serialize(true))
 	{
+		if (context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE)
+			core_frame_speculative = true;
+		// zero fill the remaining space
+		if (snapshot_max < snapshot_size)
+			memset(snapshot_buffer + snapshot_max, 0, snapshot_size - snapshot_max);
 		// to test a broken savestate, corrupt its version string
 		//++snapshot_buffer[SNAPSHOT_HEADER_SIZE+1];
 		//core_debug_bin(data,size,0); // dump uncompressed contents to log
@@ -1510,6 +1881,12 @@ RETRO_API bool retro_serialize(void *data, size_t size)
 		//core_write_file_save("hatarib_serialize_debug.bin",size,data); // for analyzing the uncompressed contents
 		result = true;
 	}
+	snapshot_incremental = false;
+	core_snapshot_refs = false;
+	core_snapshot_lean = false;
+	core_snapshot_same_instance = false;
+	if (!result) snapshot_ram_buffer = NULL; // don't trust a failed savestate
+	perf_serialize_copied = snapshot_ram_copied;
 	PERF_STOP(PERF_SERIALIZE);
 #if DEBUG_SAVESTATE_SIMPLE
 	debug_snapshot_countdown = DEBUG_SAVESTATE_SIMPLE;
@@ -1526,12 +1903,27 @@ RETRO_API bool retro_unserialize(const void *data, size_t size)
 	//core_debug_printf("retro_unserialize(%p,%z)\n",data,size);
 	//core_debug_bin(data,size,0);
 	snapshot_buffer_prepare(size,(void*)data);
+	int context = core_savestate_context();
+	if (context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE)
+		core_frame_speculative = false;
+	else if (context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY || context == RETRO_SAVESTATE_CONTEXT_ROLLBACK_NETPLAY)
+	{
+		if (!core_rewind_blocked && core_rewind_seconds > 0)
+			core_info_printf("In-core rewind is unavailable with second instance run-ahead or netplay.\n");
+		core_rewind_blocked = true;
+		core_rewind_reset();
+	}
 	if (core_serialize(false))
 	{
-		core_audio_samples_pending = 0; // clear all pending audio
+		core_audio_discard(); // clear all pending audio
 		//core_trace_next(20); // verify instructions after savestate are the same as after restore (make with DEBUG=1)
 		result = true;
 	}
+	snapshot_incremental = false;
+	core_snapshot_refs = false;
+	core_snapshot_lean = false;
+	core_snapshot_same_instance = false;
+	if (!result) snapshot_ram_buffer = NULL;
 	PERF_STOP(PERF_UNSERIALIZE);
 #if DEBUG_SAVESTATE_SIMPLE
 	debug_snapshot_countdown = DEBUG_SAVESTATE_SIMPLE;
@@ -1540,6 +1932,22 @@ RETRO_API bool retro_unserialize(const void *data, size_t size)
 	return result;
 }
 
+bool core_serialize_rewind(uint8_t* data, bool write, uint32_t* used)
+{
+	// rewind states are only restored by this instance, and only use as much of the buffer as needed
+	bool result;
+	snapshot_buffer_prepare(snapshot_size,data);
+	core_snapshot_refs = true;
+	core_snapshot_same_instance = true;
+	result = core_serialize(write);
+	if (result && !write)
+		core_audio_discard();
+	if (used) *used = (uint32_t)snapshot_max;
+	core_snapshot_refs = false;
+	core_snapshot_same_instance = false;
+	return result;
+}
+
 RETRO_API void retro_cheat_reset(void)
 {
 	core_debug_printf("retro_cheat_reset()\n");
@@ -1578,6 +1986,9 @@ RETRO_API bool retro_load_game(const struct retro_game_info *game)
 
 	retro_memory_maps();
 
+	// input movie begins with the first frame
+	core_movie_start();
+
 #if DEBUG_SAVESTATE_DUMP_AUTO
 	debug_savestate_dump_auto = DEBUG_SAVESTATE_DUMP_AUTO;
 #endif
@@ -1594,6 +2005,8 @@ RETRO_API void retro_unload_game(void)
 {
 	core_debug_printf("retro_unload_game()\n");
 	core_disk_unload_game(); // chance to save
+	core_rewind_free();
+	core_movie_stop();
 }
 
 RETRO_API unsigned retro_get_region(void)
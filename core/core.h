@@ -60,6 +60,13 @@ extern void core_video_update(void* data, int width, int height, int pitch, int
 extern void core_audio_update(const int16_t data[][2], int index, int length);
 extern void core_set_fps(int rate);
 extern void core_set_samplerate(int rate);
+// hidden frame (e.g. run-ahead): output will be discarded, so conversion/mixing can be skipped (not savestated)
+extern bool core_video_skip;
+extern bool core_audio_skip;
+// frontend accepts NULL video_cb to repeat the last frame, so unchanged frames are worth detecting
+extern bool core_video_can_dupe;
+// frontend is fast-forwarding: cheaper unfiltered audio (emulation is unaffected)
+extern bool core_audio_turbo;
 
 // indicate the core has halted or reset or some error cases
 extern void core_signal_halt(void);
@@ -82,6 +89,12 @@ extern void core_snapshot_close(void);
 extern void core_snapshot_read(char* buf, int len);
 extern void core_snapshot_write(const char* buf, int len);
 extern void core_snapshot_seek(int pos);
+extern void core_snapshot_skip(int len);
+extern void core_snapshot_ram(uint8_t* ram, uint32_t size, uint8_t* dirty, uint32_t page); // RAM with dirty page flags, cleared after
+extern uint64_t core_hash(const void* data, size_t size); // content hash for savestate references
+extern bool core_snapshot_refs; // savestate may store a content hash instead of data that can be recovered elsewhere
+extern bool core_snapshot_lean; // run-ahead or netplay rollback savestate: omit what can't change before it is restored, skip restore work
+extern bool core_snapshot_same_instance; // savestate will only be restored by this instance (run-ahead)
 
 extern int core_rand(void);
 
@@ -156,6 +156,56 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 		NULL, "system",
 		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
 	},
+	{
+		"hatarib_savestate_refs", "Savestate Content References", NULL,
+		"Savestates store only a reference to the TOS image and any unmodified floppy disks, instead of their full contents."
+		" This makes savestates faster and smaller (after compression),"
+		" but a savestate can only be restored if the same TOS and disk images are still available."
+		" Run-ahead and netplay always use references.",
+		NULL, "system",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+	},
+	{
+		"hatarib_rewind", "Rewind", NULL,
+		"Keeps a history of recent frames inside the core, stepping back while a button assigned to Rewind is held."
+		" Only the changes between frames are stored, which uses much less memory and CPU than the frontend's rewind."
+		" Two full savestates are kept in addition to the memory budget.",
+		NULL, "system",
+		{
+			{"0","Off"},
+			{"5","5 seconds"},
+			{"10","10 seconds"},
+			{"20","20 seconds"},
+			{"30","30 seconds"},
+			{"60","60 seconds"},
+			{"120","120 seconds"},
+			{NULL,NULL},
+		}, "0"
+	},
+	{
+		"hatarib_rewind_memory", "Rewind Memory", NULL,
+		"Memory budget for the rewind history. If the history doesn't fit, the oldest frames are discarded.",
+		NULL, "system",
+		{
+			{"8","8 MB"},
+			{"16","16 MB"},
+			{"32","32 MB"},
+			{"64","64 MB"},
+			{"128","128 MB"},
+			{"256","256 MB"},
+			{NULL,NULL},
+		}, "32"
+	},
+	{
+		"hatarib_input_movie", "Input Movie", NULL,
+		"Records joystick, mouse, keyboard and button actions for each emulated frame to hatarib_movie.bin in the saves folder,"
+		" or plays them back in place of live input, for repeatable benchmarks."
+		" The movie starts when content is loaded, or when a savestate is loaded to use as its starting point."
+		" A recording is saved when the content is closed."
+		" Changes take effect at the next content or savestate load.",
+		NULL, "system",
+		{{"0","Off"},{"1","Record"},{"2","Play"},{NULL,NULL}}, "0"
+	},
 	{
 		"hatarib_soft_reset", "Soft Reset", NULL,
 		"Core Restart is full cold boot by default (power off, on),"
@@ -627,6 +677,54 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 			{NULL,NULL}
 		}, "2"		
 	},
+	{
+		"hatarib_video_thread", "Threaded Video Conversion", NULL,
+		"Converts ST low and medium resolution frames on a second CPU core while the next frame is emulated."
+		" Frees time on slow devices with overscan, but adds one frame of video latency."
+		" Spectrum 512, high resolution, TT and Falcon are always converted on the emulation thread.",
+		NULL, "video",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+	},
+	{
+		"hatarib_frameskip", "Frameskip", NULL,
+		"Skips video conversion for some frames on slow devices, the previous frame is shown again."
+		" Emulation and sound are not skipped."
+		" Auto skips when the frontend expects its audio buffer to run out,"
+		" Aggressive when the audio buffer is below the threshold,"
+		" and the others skip a fixed number of frames.",
+		NULL, "video",
+		{
+			{"0","Off"},
+			{"1","Auto"},
+			{"2","Aggressive"},
+			{"3","Skip 1 of 2"},
+			{"4","Skip 2 of 3"},
+			{"5","Skip 3 of 4"},
+			{NULL,NULL}
+		}, "0"
+	},
+	{
+		"hatarib_frameskip_threshold", "Frameskip Threshold", NULL,
+		"Aggressive frameskip skips frames while the frontend's audio buffer is less full than this.",
+		NULL, "video",
+		{
+			{"15","15%"},
+			{"20","20%"},
+			{"25","25%"},
+			{"33","33%"},
+			{"40","40%"},
+			{"50","50%"},
+			{"60","60%"},
+			{NULL,NULL}
+		}, "33"
+	},
+	{
+		"hatarib_turbo", "Fast-Forward Turbo", NULL,
+		"While the frontend is fast-forwarding or not throttled, convert only as many frames per second as are normally shown,"
+		" and use simpler audio resampling. The emulation itself is not affected.",
+		NULL, "video",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
+	},
 	{
 		"hatarib_show_welcome", "Show Welcome Message", NULL,
 		"At startup the status bar shows a welcome message for 5 seconds, if enabled.",
@@ -669,13 +767,15 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 	},
 	{
 		"hatarib_lpf", "Lowpass Filter", NULL,
-		"Reduces high frequency noise from sound output to reduce harshness.",
+		"Reduces high frequency noise from sound output to reduce harshness."
+		" Band-limited Resampler replaces the resampling with a sharp filter that removes aliasing above the output rate.",
 		NULL, "audio",
 		{
 			{"0","None"},
 			{"1","Hatari STF"},
 			{"2","Hatari STE/Falcon"},
 			{"3","Clean Lowpass"},
+			{"4","Band-limited Resampler"},
 			{NULL,NULL}
 		}, "3"
 	},
@@ -833,6 +933,30 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 		NULL, "advanced",
 		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
 	},
+	{
+		"hatarib_idle_skip", "CPU Idle Loop Skip", NULL,
+		"Skips the repeated iterations of short 68000 loops that wait in RAM for an interrupt,"
+		" such as waiting for the next vertical blank. The emulation result is identical, but uses less host CPU.",
+		NULL, "advanced",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
+	},
+	{
+		"hatarib_dsp_lazy", "Falcon DSP Catch-up", NULL,
+		"Runs the Falcon DSP in batches when the CPU or sound hardware communicates with it,"
+		" instead of after every CPU instruction. The emulation result is the same."
+		" While a program uses the DSP host port interrupts or handshake mode sound transfers,"
+		" the DSP still runs after every CPU instruction, and only the first transfer after"
+		" switching to handshake mode may start late.",
+		NULL, "advanced",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+	},
+	{
+		"hatarib_dsp_cache", "Falcon DSP Decode Cache", NULL,
+		"Remembers the decoded Falcon DSP instruction at each program address,"
+		" until the program memory there is written.",
+		NULL, "advanced",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+	},
 	{
 		"hatarib_mmu", "MMU Emulation", NULL,
 		"Causes restart!! For TT or Falcon. Uses more CPU power.",
@@ -857,9 +981,12 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 	{
 		"hatarib_perf_counters", "Performance Counters", NULL,
 		"Display performance timing on the status bar: "
-		"frame (average) + last: reset, savestate, restore (μs)",
+		"frame (average) + last: reset, savestate, restore (μs), "
+		"RAM copied by savestate (KB). "
+		"DSP Cache replaces the last four with the Falcon DSP instructions of the last frame, "
+		"and the percentage found in the decode cache.",
 		NULL, "advanced",
-		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+		{{"0","Off"},{"1","On"},{"2","DSP Cache"},{NULL,NULL}}, "0"
 	},
 	#if CORE_DEBUG
 	{
@@ -1119,6 +1246,10 @@ void core_config_read_newparam()
 	CFG_INT("hatarib_fast_floppy") newparam.DiskImage.FastFloppy = vi;
 	CFG_INT("hatarib_save_floppy") core_disk_enable_save = vi;
 	CFG_INT("hatarib_savestate_floppy_modify") core_savestate_floppy_modify = (vi != 0);
+	CFG_INT("hatarib_savestate_refs") core_savestate_refs = (vi != 0);
+	CFG_INT("hatarib_rewind") core_rewind_seconds = vi;
+	CFG_INT("hatarib_rewind_memory") core_rewind_memory = vi;
+	CFG_INT("hatarib_input_movie") core_movie_mode = vi;
 	CFG_INT("hatarib_soft_reset") core_option_soft_reset = vi;
  	CFG_INT("hatarib_machine")
 	{
@@ -1191,6 +1322,10 @@ void core_config_read_newparam()
 	CFG_INT("hatarib_statusbar") { newparam.Screen.bShowStatusbar = (vi==1); newparam.Screen.bShowDriveLed = (vi==2); }
 	CFG_INT("hatarib_aspect") { if (core_video_aspect_mode != vi) { core_video_aspect_mode = vi; core_video_changed = true; } }
 	CFG_INT("hatarib_pause_osk") core_pause_osk = vi;
+	CFG_INT("hatarib_video_thread") core_video_thread = (vi != 0);
+	CFG_INT("hatarib_frameskip") core_frameskip = vi;
+	CFG_INT("hatarib_frameskip_threshold") core_frameskip_threshold = vi;
+	CFG_INT("hatarib_turbo") core_turbo = (vi != 0);
 	CFG_INT("hatarib_show_welcome") core_show_welcome = vi;
 	CFG_INT("hatarib_boot_alert") core_boot_alert = vi;
 	CFG_INT("hatarib_samplerate") newparam.Sound.nPlaybackFreq = vi;
@@ -1211,8 +1346,11 @@ void core_config_read_newparam()
 	CFG_INT("hatarib_prefetch") newparam.System.bCompatibleCpu = vi;
 	CFG_INT("hatarib_cycle_exact") newparam.System.bCycleExactCpu = vi;
 	CFG_INT("hatarib_mmu") newparam.System.bMMU = vi;
+	CFG_INT("hatarib_idle_skip") core_idle_skip = (vi != 0);
+	CFG_INT("hatarib_dsp_lazy") core_dsp_lazy = (vi != 0);
+	CFG_INT("hatarib_dsp_cache") core_dsp_cache = (vi != 0);
 	CFG_INT("hatarib_log_hatari") newparam.Log.nTextLogLevel = vi;
-	CFG_INT("hatarib_perf_counters") core_perf_display = (vi != 0);
+	CFG_INT("hatarib_perf_counters") core_perf_display = vi;
 	#if CORE_DEBUG
 		CFG_INT("hatarib_tracing") core_tracing = vi;
 		CFG_INT("hatarib_input_debug") core_input_debug = vi;
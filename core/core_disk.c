@@ -1043,6 +1043,19 @@ void core_disk_unload_game(void)
 	disks_clear();
 }
 
+bool core_disk_image(const char* filename, uint8_t** data, unsigned int* size)
+{
+	// used to recover unmodified floppy data referenced by a savestate
+	for (int i=0; i<MAX_DISKS; ++i)
+	{
+		if (disks[i].data == NULL || strcmp(disks[i].filename,filename)) continue;
+		*data = disks[i].data;
+		*size = disks[i].size;
+		return true;
+	}
+	return false;
+}
+
 void core_disk_reindex(void)
 {
 	// after loading a savesate, remap the loaded disks to the ones we have in core_disk
@@ -51,6 +51,9 @@ const float DPAD_MOUSE_SPEED = 0.3; // scale of d-pad relative to analog max
 // AUX_SET(b,MOUSE_L) sets MOUSE_L to the state of b
 
 #define JOY_PORTS   6
+#if (JOY_PORTS * 2) != CORE_MOVIE_JOY
+	#error "CORE_MOVIE_JOY must hold stick and fire for each port"
+#endif
 // 1-button joysticks
 #define JOY_STICK_U    0x01
 #define JOY_STICK_D    0x02
@@ -182,6 +185,113 @@ static void event_queue_finish(void)
 		core_warn_printf("core event_queue not empty at end of retro_run? %d",event_queue_len);
 }
 
+//
+// input movie
+//
+
+static void movie_event_from_sdl(struct core_movie_event* m, const SDL_Event* event)
+{
+	memset(m,0,sizeof(*m));
+	switch (event->type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		m->type = (event->type == SDL_KEYDOWN) ? CORE_MOVIE_KEYDOWN : CORE_MOVIE_KEYUP;
+		m->data = event->key.repeat;
+		m->sym = event->key.keysym.sym;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		m->type = (event->type == SDL_MOUSEBUTTONDOWN) ? CORE_MOVIE_BUTTONDOWN : CORE_MOVIE_BUTTONUP;
+		m->data = event->button.button;
+		m->x = (int16_t)event->button.x;
+		m->y = (int16_t)event->button.y;
+		break;
+	default: // SDL_MOUSEMOTION
+		m->type = CORE_MOVIE_MOTION;
+		m->data = (uint8_t)event->motion.state;
+		m->x = (int16_t)event->motion.x;
+		m->y = (int16_t)event->motion.y;
+		m->xrel = (int16_t)event->motion.xrel;
+		m->yrel = (int16_t)event->motion.yrel;
+		break;
+	}
+}
+
+static void movie_event_to_sdl(SDL_Event* event, const struct core_movie_event* m)
+{
+	memset(event,0,sizeof(*event));
+	switch (m->type)
+	{
+	case CORE_MOVIE_KEYDOWN:
+	case CORE_MOVIE_KEYUP:
+		{
+			bool down = (m->type == CORE_MOVIE_KEYDOWN);
+			event->key.type = down ? SDL_KEYDOWN : SDL_KEYUP;
+			event->key.state = down ? SDL_PRESSED : SDL_RELEASED;
+			event->key.repeat = m->data;
+			event->key.keysym.sym = m->sym;
+		}
+		break;
+	case CORE_MOVIE_BUTTONDOWN:
+	case CORE_MOVIE_BUTTONUP:
+		{
+			bool down = (m->type == CORE_MOVIE_BUTTONDOWN);
+			event->button.type = down ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+			event->button.button = m->data;
+			event->button.state = down ? SDL_PRESSED : SDL_RELEASED;
+			event->button.clicks = 1;
+			event->button.x = m->x;
+			event->button.y = m->y;
+		}
+		break;
+	default: // CORE_MOVIE_MOTION
+		event->motion.type = SDL_MOUSEMOTION;
+		event->motion.state = m->data;
+		event->motion.x = m->x;
+		event->motion.y = m->y;
+		event->motion.xrel = m->xrel;
+		event->motion.yrel = m->yrel;
+		break;
+	}
+}
+
+static void movie_record(void)
+{
+	uint8_t joy[CORE_MOVIE_JOY];
+	struct core_movie_event events[EVENT_QUEUE_SIZE];
+	for (int i=0; i<JOY_PORTS; ++i)
+	{
+		joy[i] = (uint8_t)joy_stick[i];
+		joy[JOY_PORTS+i] = (uint8_t)joy_fire[i];
+	}
+	for (int i=0; i<event_queue_len; ++i)
+		movie_event_from_sdl(&events[i],&event_queue[(event_queue_pos + i) % EVENT_QUEUE_SIZE]);
+	core_movie_record(joy,events,event_queue_len);
+}
+
+static void movie_play(void)
+{
+	uint8_t joy[CORE_MOVIE_JOY];
+	const struct core_movie_event* events;
+	int count;
+	if (!core_movie_play(joy,&events,&count)) return;
+	// replace live input
+	event_queue_pos = 0;
+	event_queue_len = 0;
+	for (int i=0; i<count; ++i)
+	{
+		SDL_Event event;
+		movie_event_to_sdl(&event,&events[i]);
+		event_queue_push(&event);
+	}
+	for (int i=0; i<JOY_PORTS; ++i)
+	{
+		joy_stick[i] = joy[i];
+		joy_fire[i] = joy[JOY_PORTS+i];
+	}
+}
+
 //
 // Key translation
 //
@@ -313,6 +423,7 @@ void core_input_serialize(void)
 	core_serialize_int32(&osk_press_key);
 	core_serialize_int32(&osk_press_time);
 	core_serialize_int32(&jm_toggle_index);
+	core_movie_serialize();
 }
 
 void core_input_set_environment(retro_environment_t cb)
@@ -405,6 +516,7 @@ void core_input_update(void)
 	bool statusbar = false;
 	bool jm_toggle = false;
 	int jm_toggle_source = -1;
+	bool rewind = false;
 	bool pause = false;
 	bool osk_on = false;
 	bool osk_shot = false;
@@ -658,6 +770,7 @@ void core_input_update(void)
 					RETROK_KP9,
 				};
 				#define BUTTON_KEY_COUNT   (sizeof(BUTTON_KEY)/sizeof(BUTTON_KEY[0]))
+				#define BUTTON_REWIND      (BUTTON_KEY_START + BUTTON_KEY_COUNT) // follows the last key
 
 				const int m = core_button_map[i][k];
 
@@ -674,8 +787,8 @@ void core_input_update(void)
 				if (input_osk_key && is_osk) continue; // when using OSK hide these buttons
 
 				// regular mappings
-				if (m >= (BUTTON_KEY_START + BUTTON_KEY_COUNT)) continue;
-				if (m >= BUTTON_KEY_START)
+				if (m > BUTTON_REWIND) continue;
+				if (m >= BUTTON_KEY_START && m < BUTTON_REWIND)
 				{
 					if (!input_paused)
 						core_input_keyboard_joy(BUTTON_KEY[m-BUTTON_KEY_START]);
@@ -801,6 +914,9 @@ void core_input_update(void)
 						jm_toggle = true;
 						jm_toggle_source = i; // always affects the last person to press it
 						break;
+					case BUTTON_REWIND: // Rewind
+						rewind = true;
+						break;
 					}
 				}
 			}
@@ -951,6 +1067,7 @@ void core_input_update(void)
 		cpu_speed = false;
 		statusbar = false;
 		jm_toggle = false;
+		rewind = false;
 		if (input_osk_shot) pause = false; // cancel only if in OSK one-shot mode (otherwise we need it to unpause!)
 	}
 	else
@@ -965,23 +1082,32 @@ void core_input_update(void)
 
 	// auxiliary buttons
 
-	// select drive
-	if (drive_swap && !AUX(DRIVE_SWAP)) core_disk_drive_toggle();
+	// actions that affect emulation can be recorded or replaced by the input movie
+	uint8_t actions = 0;
+	if (drive_swap && !AUX(DRIVE_SWAP)) actions |= CORE_MOVIE_DRIVE_SWAP;
+	if (disk_swap  && !AUX(DISK_SWAP )) actions |= CORE_MOVIE_DISK_SWAP;
+	if (warm_boot  && !AUX(WARM_BOOT )) actions |= CORE_MOVIE_WARM_BOOT;
+	if (cold_boot  && !AUX(COLD_BOOT )) actions |= CORE_MOVIE_COLD_BOOT;
+	if (cpu_speed  && !AUX(CPU_SPEED )) actions |= CORE_MOVIE_CPU_SPEED;
 	AUX_SET(drive_swap,DRIVE_SWAP);
+	AUX_SET(disk_swap,DISK_SWAP);
+	AUX_SET(warm_boot,WARM_BOOT);
+	AUX_SET(cold_boot,COLD_BOOT);
+	AUX_SET(cpu_speed,CPU_SPEED);
+	actions = core_movie_actions(actions);
+
+	// select drive
+	if (actions & CORE_MOVIE_DRIVE_SWAP) core_disk_drive_toggle();
 
 	// swap disk
-	if (disk_swap && !AUX(DISK_SWAP)) core_disk_swap();
-	AUX_SET(disk_swap,DISK_SWAP);
+	if (actions & CORE_MOVIE_DISK_SWAP) core_disk_swap();
 
 	// perform reset
-	if (warm_boot && !AUX(WARM_BOOT)) Reset_Warm();
-	if (cold_boot && !AUX(COLD_BOOT)) core_reset_colder();
-	AUX_SET(warm_boot,WARM_BOOT);
-	AUX_SET(cold_boot,COLD_BOOT);
+	if (actions & CORE_MOVIE_WARM_BOOT) Reset_Warm();
+	if (actions & CORE_MOVIE_COLD_BOOT) core_reset_colder();
 
 	// CPU speed cycle
-	if (cpu_speed && !AUX(CPU_SPEED)) config_cycle_cpu_speed();
-	AUX_SET(cpu_speed,CPU_SPEED);
+	if (actions & CORE_MOVIE_CPU_SPEED) config_cycle_cpu_speed();
 
 	// status bar toggle
 	if (statusbar && !AUX(STATUSBAR)) config_toggle_statusbar();
@@ -995,6 +1121,9 @@ void core_input_update(void)
 	}
 	AUX_SET(jm_toggle,JM_TOGGLE);
 
+	// rewind is held, not toggled
+	core_rewind_held = rewind;
+
 	// pause/help toggle
 	// onscreen keyboard toggle
 	if (pause && !AUX(PAUSE))
@@ -1064,12 +1193,21 @@ void core_input_update(void)
 
 void core_input_post(void)
 {
+	int movie = core_movie_active();
+	if (movie != CORE_MOVIE_OFF)
+	{
+		// with an input movie, events wait for the next emulated frame
+		if (core_runflags & (CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE)) return;
+		if (movie == CORE_MOVIE_RECORD) movie_record();
+		else                            movie_play();
+	}
 	event_queue_force_feed();
 }
 
 void core_input_finish(void)
 {
-	event_queue_finish();
+	if (core_movie_active() == CORE_MOVIE_OFF)
+		event_queue_finish();
 }
 
 int core_poll_event(SDL_Event* event)
@@ -19,14 +19,31 @@ extern int core_crashtime;
 extern bool core_show_welcome;
 extern bool core_boot_alert;
 extern bool core_first_reset;
-extern bool core_perf_display;
+extern int core_perf_display; // hatarib_perf_counters option, 2 = DSP decode cache
+extern bool core_video_thread; // hatarib_video_thread option
+extern int core_frameskip; // hatarib_frameskip option: 0 off, 1 auto, 2 aggressive, 3+ skip (core_frameskip-2) of (core_frameskip-1)
+extern bool core_turbo; // hatarib_turbo option
+extern int core_frameskip_threshold; // hatarib_frameskip_threshold option, frontend audio buffer occupancy % for aggressive
+extern bool core_idle_skip; // hatarib_idle_skip option, used by newcpu.c
+extern uint64_t core_idle_skip_cycles; // CPU cycles skipped by newcpu.c, for make bench
+#if CORE_PREDECODE_TEST
+extern uint64_t core_predecode_hits; // predecode cache prototype in newcpu.c, for make bench PREDECODE_TEST=1
+extern uint64_t core_predecode_misses;
+#endif
+extern bool core_dsp_lazy; // hatarib_dsp_lazy option, used by dsp.c
+extern bool core_dsp_cache; // hatarib_dsp_cache option, used by dsp_cpu.c
+extern uint32_t core_dsp_cache_hits; // DSP decode cache counters, for the performance display
+extern uint32_t core_dsp_cache_misses;
 extern bool core_midi_enable;
+extern bool core_savestate_refs;
 extern int core_video_fps;
 extern bool core_statusbar_restore;
 #if CORE_DEBUG
 extern int core_tracing;
 #endif
 
+extern void core_perf_totals(retro_time_t* run, retro_time_t* run_reset, retro_time_t* serialize, retro_time_t* unserialize); // accumulated usec, for bench/bench.c
+
 extern bool core_midi_read(uint8_t* data);
 extern bool core_midi_write(uint8_t data);
 
@@ -36,6 +53,7 @@ extern void core_serialize_int32(int32_t *x);
 extern void core_serialize_uint32(uint32_t *x);
 extern void core_serialize_data(void* d, size_t size);
 extern void core_serialize_skip(size_t size);
+extern bool core_serialize_rewind(uint8_t* data, bool write, uint32_t* used); // savestate for core_rewind.c, used returns bytes used
 
 // core_file.c
 extern void strcpy_trunc(char* dest, const char* src, unsigned int len);
@@ -135,6 +153,49 @@ extern bool core_disk_save_exists(const char* filename);
 extern bool core_disk_enable_b;
 extern bool core_disk_enable_save;
 extern bool core_savestate_floppy_modify;
+extern bool core_disk_image(const char* filename, uint8_t** data, unsigned int* size); // cached file data for a disk image, by filename
+
+// core_rewind.c
+extern int core_rewind_seconds; // 0 = off
+extern int core_rewind_memory; // MB
+extern bool core_rewind_held; // set by core_input_update
+extern void core_rewind_capture(void); // call after each frame to add it to the history
+extern bool core_rewind_step(void); // restores the previous frame from history, false if unavailable
+extern void core_rewind_reset(void); // discard history
+extern void core_rewind_free(void);
+
+// core_movie.c
+#define CORE_MOVIE_OFF      0
+#define CORE_MOVIE_RECORD   1
+#define CORE_MOVIE_PLAY     2
+#define CORE_MOVIE_JOY      12 // stick then fire for 6 joystick ports
+// triggered actions
+#define CORE_MOVIE_DRIVE_SWAP   0x01
+#define CORE_MOVIE_DISK_SWAP    0x02
+#define CORE_MOVIE_WARM_BOOT    0x04
+#define CORE_MOVIE_COLD_BOOT    0x08
+#define CORE_MOVIE_CPU_SPEED    0x10
+// event types
+#define CORE_MOVIE_KEYDOWN      0
+#define CORE_MOVIE_KEYUP        1
+#define CORE_MOVIE_BUTTONDOWN   2
+#define CORE_MOVIE_BUTTONUP     3
+#define CORE_MOVIE_MOTION       4
+struct core_movie_event
+{
+	uint8_t type;
+	uint8_t data; // key: repeat, button: button, motion: button state mask
+	int32_t sym;
+	int16_t x, y, xrel, yrel;
+};
+extern int core_movie_mode; // option, takes effect at the next content or savestate load
+extern int core_movie_active(void); // CORE_MOVIE_OFF once playback has finished
+extern void core_movie_start(void); // at content load, starts recording or playback at frame 0
+extern void core_movie_stop(void); // at content unload, saves the recording
+extern void core_movie_serialize(void);
+extern uint8_t core_movie_actions(uint8_t actions); // records triggered actions, or replaces them with the movie's
+extern void core_movie_record(const uint8_t* joy, const struct core_movie_event* e, int count); // for each emulated frame
+extern bool core_movie_play(uint8_t* joy, const struct core_movie_event** e, int* count); // for each emulated frame, false if finished
 
 // core_config.c
 extern void core_config_set_environment(retro_environment_t cb); // call after core_disk_set_environment (which scans system folder for TOS etc)
@@ -260,6 +321,8 @@ extern int32_t core_osk_mode;
 // Also make sure the defaults still match OPTION_PAD below (e.g. key space / key return on L3/R3)
 // If the key list is re-ordered, also adjust BUTTON_KEY in core_input.c.
 
+// Actions added after the keys (Rewind) go at the end of the list, so that saved key mappings keep their values.
+
 // This is the index of the first key (space)
 #define BUTTON_KEY_START   26
 
@@ -385,6 +448,7 @@ extern int32_t core_osk_mode;
 		{"","Key Numpad 7"}, \
 		{"","Key Numpad 8"}, \
 		{"","Key Numpad 9"}, \
+		{"120","Rewind"}, \
 		{NULL,NULL} \
 	}
 // default should match OPTION_PAD below
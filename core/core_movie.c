@@ -0,0 +1,414 @@
+// input movie
+//
+// Records the input given to Hatari for each emulated frame (joysticks, keyboard and mouse events, triggered actions),
+// or plays it back in place of the live input, for repeatable benchmark and profiling runs.
+// The movie starts when content is loaded, or restarts when a savestate is loaded.
+// The current movie frame is part of the savestate, so run-ahead, rewind and netplay rollback
+// follow the movie without any special handling: recording simply overwrites frames from the restored position.
+
+#include "../libretro/libretro.h"
+#include "core.h"
+#include "core_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MOVIE_FILENAME   "hatarib_movie.bin"
+#define MOVIE_MAGIC      0x564D4248 // HBMV
+#define MOVIE_VERSION    1
+#define MOVIE_HEADER     16
+
+// file frame flags
+#define MOVIE_FRAME_JOY       0x01 // joystick state changed
+#define MOVIE_FRAME_ACTIONS   0x02
+#define MOVIE_FRAME_EVENTS    0x04
+
+struct movie_frame
+{
+	uint8_t joy[CORE_MOVIE_JOY];
+	uint8_t actions;
+	uint8_t event_count;
+	uint32_t event_pos;
+};
+
+int core_movie_mode = CORE_MOVIE_OFF;
+
+static int movie_state = CORE_MOVIE_OFF; // mode latched at core_movie_start
+static uint32_t movie_frame = 0; // next frame to record or play
+static uint32_t movie_actions_frame = 0xFFFFFFFF; // frame whose actions have already been played
+static uint8_t movie_actions_pending = 0; // actions to record with the next frame
+static bool movie_finished = false;
+
+static struct movie_frame* frames = NULL;
+static uint32_t frame_count = 0;
+static uint32_t frame_alloc = 0;
+static struct core_movie_event* events = NULL;
+static uint32_t event_count = 0;
+static uint32_t event_alloc = 0;
+
+//
+// movie buffers
+//
+
+static void movie_free(void)
+{
+	free(frames); frames = NULL;
+	free(events); events = NULL;
+	frame_count = frame_alloc = 0;
+	event_count = event_alloc = 0;
+}
+
+static bool movie_reserve(uint32_t frames_needed, uint32_t events_needed)
+{
+	if (frames_needed > frame_alloc)
+	{
+		uint32_t n = frame_alloc ? (frame_alloc * 2) : 4096;
+		while (n < frames_needed) n *= 2;
+		struct movie_frame* f = realloc(frames, sizeof(struct movie_frame) * n);
+		if (!f) return false;
+		frames = f;
+		frame_alloc = n;
+	}
+	if (events_needed > event_alloc)
+	{
+		uint32_t n = event_alloc ? (event_alloc * 2) : 4096;
+		while (n < events_needed) n *= 2;
+		struct core_movie_event* e = realloc(events, sizeof(struct core_movie_event) * n);
+		if (!e) return false;
+		events = e;
+		event_alloc = n;
+	}
+	return true;
+}
+
+//
+// file format (little-endian)
+//
+// header: magic, version, frame count, event count (uint32 each)
+// frame: flags, [joy CORE_MOVIE_JOY bytes], [actions], [event count, events]
+// event: type, then
+//   key:    sym (int32), repeat (uint8)
+//   button: button (uint8), x, y (int16)
+//   motion: state (uint8), x, y, xrel, yrel (int16)
+//
+
+static uint8_t* put16(uint8_t* p, int16_t v) { uint16_t u = (uint16_t)v; p[0] = u & 0xFF; p[1] = u >> 8; return p+2; }
+static uint8_t* put32(uint8_t* p, uint32_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = v >> 24; return p+4; }
+static int16_t get16(const uint8_t* p) { return (int16_t)(uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static bool movie_save(void)
+{
+	// worst case size
+	size_t size = MOVIE_HEADER + ((size_t)frame_count * (1 + CORE_MOVIE_JOY + 1 + 1)) + ((size_t)event_count * 10);
+	uint8_t* data = malloc(size);
+	if (!data) return false;
+	uint8_t* p = data;
+	p = put32(p, MOVIE_MAGIC);
+	p = put32(p, MOVIE_VERSION);
+	p = put32(p, frame_count);
+	p = put32(p, event_count);
+	static const uint8_t JOY_NONE[CORE_MOVIE_JOY] = {0};
+	const uint8_t* joy_last = JOY_NONE;
+	for (uint32_t i=0; i<frame_count; ++i)
+	{
+		const struct movie_frame* f = &frames[i];
+		uint8_t* flags = p++;
+		*flags = 0;
+		if (memcmp(f->joy, joy_last, CORE_MOVIE_JOY))
+		{
+			*flags |= MOVIE_FRAME_JOY;
+			memcpy(p, f->joy, CORE_MOVIE_JOY);
+			p += CORE_MOVIE_JOY;
+			joy_last = f->joy;
+		}
+		if (f->actions)
+		{
+			*flags |= MOVIE_FRAME_ACTIONS;
+			*p++ = f->actions;
+		}
+		if (f->event_count)
+		{
+			*flags |= MOVIE_FRAME_EVENTS;
+			*p++ = f->event_count;
+			for (uint32_t j=0; j<f->event_count; ++j)
+			{
+				const struct core_movie_event* e = &events[f->event_pos+j];
+				*p++ = e->type;
+				switch (e->type)
+				{
+				case CORE_MOVIE_KEYDOWN:
+				case CORE_MOVIE_KEYUP:
+					p = put32(p, (uint32_t)e->sym);
+					*p++ = e->data;
+					break;
+				case CORE_MOVIE_BUTTONDOWN:
+				case CORE_MOVIE_BUTTONUP:
+					*p++ = e->data;
+					p = put16(p, e->x);
+					p = put16(p, e->y);
+					break;
+				default: // CORE_MOVIE_MOTION
+					*p++ = e->data;
+					p = put16(p, e->x);
+					p = put16(p, e->y);
+					p = put16(p, e->xrel);
+					p = put16(p, e->yrel);
+					break;
+				}
+			}
+		}
+	}
+	bool result = core_write_file_save(MOVIE_FILENAME, (unsigned int)(p - data), data);
+	free(data);
+	return result;
+}
+
+static bool movie_load(void)
+{
+	unsigned int size = 0;
+	uint8_t* data = core_read_file_save(MOVIE_FILENAME, &size);
+	if (!data) return false;
+	bool result = false;
+	const uint8_t* p = data;
+	const uint8_t* end = data + size;
+	if (size < MOVIE_HEADER || get32(p) != MOVIE_MAGIC || get32(p+4) != MOVIE_VERSION)
+	{
+		core_error_printf("Input movie %s: not a movie file, or unsupported version.\n", MOVIE_FILENAME);
+		goto finish;
+	}
+	uint32_t fc = get32(p+8);
+	uint32_t ec = get32(p+12);
+	p += MOVIE_HEADER;
+	if (fc > size || ec > size || !movie_reserve(fc, ec)) // each frame or event is at least 1 byte
+	{
+		core_error_printf("Input movie %s: invalid size.\n", MOVIE_FILENAME);
+		goto finish;
+	}
+	uint8_t joy[CORE_MOVIE_JOY] = {0};
+	uint32_t e_pos = 0;
+	#define NEED(n_)   if ((end - p) < (n_)) goto truncated;
+	for (uint32_t i=0; i<fc; ++i)
+	{
+		struct movie_frame* f = &frames[i];
+		NEED(1);
+		uint8_t flags = *p++;
+		if (flags & MOVIE_FRAME_JOY)
+		{
+			NEED(CORE_MOVIE_JOY);
+			memcpy(joy, p, CORE_MOVIE_JOY);
+			p += CORE_MOVIE_JOY;
+		}
+		memcpy(f->joy, joy, CORE_MOVIE_JOY);
+		f->actions = 0;
+		if (flags & MOVIE_FRAME_ACTIONS)
+		{
+			NEED(1);
+			f->actions = *p++;
+		}
+		f->event_count = 0;
+		f->event_pos = e_pos;
+		if (flags & MOVIE_FRAME_EVENTS)
+		{
+			NEED(1);
+			f->event_count = *p++;
+			if ((e_pos + f->event_count) > ec) goto truncated;
+			for (uint32_t j=0; j<f->event_count; ++j)
+			{
+				struct core_movie_event* e = &events[e_pos++];
+				memset(e, 0, sizeof(*e));
+				NEED(1);
+				e->type = *p++;
+				switch (e->type)
+				{
+				case CORE_MOVIE_KEYDOWN:
+				case CORE_MOVIE_KEYUP:
+					NEED(5);
+					e->sym = (int32_t)get32(p);
+					e->data = p[4];
+					p += 5;
+					break;
+				case CORE_MOVIE_BUTTONDOWN:
+				case CORE_MOVIE_BUTTONUP:
+					NEED(5);
+					e->data = p[0];
+					e->x = get16(p+1);
+					e->y = get16(p+3);
+					p += 5;
+					break;
+				case CORE_MOVIE_MOTION:
+					NEED(9);
+					e->data = p[0];
+					e->x = get16(p+1);
+					e->y = get16(p+3);
+					e->xrel = get16(p+5);
+					e->yrel = get16(p+7);
+					p += 9;
+					break;
+				default:
+					goto truncated;
+				}
+			}
+		}
+	}
+	#undef NEED
+	frame_count = fc;
+	event_count = e_pos;
+	result = true;
+	goto finish;
+truncated:
+	core_error_printf("Input movie %s: corrupt or truncated.\n", MOVIE_FILENAME);
+finish:
+	free(data);
+	return result;
+}
+
+//
+// public interface
+//
+
+int core_movie_active(void)
+{
+	if (movie_state == CORE_MOVIE_PLAY && movie_frame >= frame_count)
+	{
+		if (!movie_finished)
+		{
+			core_info_printf("Input movie finished at frame %d.\n", movie_frame);
+			core_signal_alert("Movie Finished");
+			movie_finished = true;
+		}
+		return CORE_MOVIE_OFF;
+	}
+	return movie_state;
+}
+
+void core_movie_start(void)
+{
+	// a recording in progress is kept if the mode has changed, or discarded by a restart
+	if (movie_state == CORE_MOVIE_RECORD && core_movie_mode != CORE_MOVIE_RECORD)
+		core_movie_stop();
+	movie_frame = 0;
+	movie_actions_frame = 0xFFFFFFFF;
+	movie_actions_pending = 0;
+	movie_finished = false;
+	if (core_movie_mode == CORE_MOVIE_RECORD)
+	{
+		frame_count = 0;
+		event_count = 0;
+		if (movie_state != CORE_MOVIE_RECORD)
+			core_info_printf("Input movie recording: %s\n", MOVIE_FILENAME);
+		movie_state = CORE_MOVIE_RECORD;
+	}
+	else if (core_movie_mode == CORE_MOVIE_PLAY)
+	{
+		if (movie_state != CORE_MOVIE_PLAY)
+		{
+			movie_free();
+			if (!movie_load())
+			{
+				core_error_printf("Input movie playback could not load: %s\n", MOVIE_FILENAME);
+				core_signal_alert2("Movie not found: ", MOVIE_FILENAME);
+				movie_state = CORE_MOVIE_OFF;
+				return;
+			}
+			core_info_printf("Input movie playback: %s (%d frames)\n", MOVIE_FILENAME, frame_count);
+		}
+		movie_state = CORE_MOVIE_PLAY;
+	}
+	else
+	{
+		movie_free();
+		movie_state = CORE_MOVIE_OFF;
+	}
+}
+
+void core_movie_stop(void)
+{
+	if (movie_state == CORE_MOVIE_RECORD)
+	{
+		if (movie_save())
+			core_info_printf("Input movie saved: %s (%d frames)\n", MOVIE_FILENAME, frame_count);
+		else
+			core_error_printf("Input movie could not be saved: %s\n", MOVIE_FILENAME);
+	}
+	movie_free();
+	movie_state = CORE_MOVIE_OFF;
+}
+
+void core_movie_serialize(void)
+{
+	uint32_t frame = movie_frame;
+	core_serialize_uint32(&frame);
+	if (core_serialize_write) return;
+	// states from this session return to their frame of the movie,
+	// a savestate loaded by the user is the start of a new one
+	if (core_snapshot_same_instance || core_snapshot_lean)
+	{
+		if (movie_state == CORE_MOVIE_OFF) return;
+		movie_frame = frame;
+		movie_actions_frame = 0xFFFFFFFF;
+		movie_actions_pending = 0;
+		if (movie_frame < frame_count) movie_finished = false;
+	}
+	else
+	{
+		core_movie_start();
+	}
+}
+
+uint8_t core_movie_actions(uint8_t actions)
+{
+	int mode = core_movie_active();
+	if (mode == CORE_MOVIE_RECORD)
+	{
+		movie_actions_pending |= actions;
+	}
+	else if (mode == CORE_MOVIE_PLAY)
+	{
+		// once per frame, even if paused before the frame runs
+		actions = 0;
+		if (movie_actions_frame != movie_frame)
+		{
+			actions = frames[movie_frame].actions;
+			movie_actions_frame = movie_frame;
+		}
+	}
+	return actions;
+}
+
+void core_movie_record(const uint8_t* joy, const struct core_movie_event* e, int count)
+{
+	if (movie_state != CORE_MOVIE_RECORD) return;
+	// overwrite anything after this frame (e.g. after run-ahead or rewind)
+	if (movie_frame < frame_count)
+	{
+		frame_count = movie_frame;
+		event_count = frames[movie_frame].event_pos;
+	}
+	if (!movie_reserve(frame_count + 1, event_count + count))
+	{
+		core_error_printf("Input movie recording out of memory at frame %d.\n", movie_frame);
+		core_movie_stop();
+		return;
+	}
+	struct movie_frame* f = &frames[frame_count];
+	memcpy(f->joy, joy, CORE_MOVIE_JOY);
+	f->actions = movie_actions_pending;
+	f->event_count = (uint8_t)count;
+	f->event_pos = event_count;
+	memcpy(events + event_count, e, sizeof(struct core_movie_event) * count);
+	event_count += count;
+	++frame_count;
+	movie_frame = frame_count;
+	movie_actions_pending = 0;
+}
+
+bool core_movie_play(uint8_t* joy, const struct core_movie_event** e, int* count)
+{
+	if (movie_state != CORE_MOVIE_PLAY || movie_frame >= frame_count) return false;
+	const struct movie_frame* f = &frames[movie_frame];
+	memcpy(joy, f->joy, CORE_MOVIE_JOY);
+	*e = events + f->event_pos;
+	*count = f->event_count;
+	++movie_frame;
+	return true;
+}
@@ -0,0 +1,335 @@
+// in-core rewind
+//
+// A ring of recent savestates, kept as XOR deltas so that only the changed parts are stored.
+// The newest state is kept in full, and each ring entry is the XOR of a state against the one before it,
+// so stepping back is: previous = newest ^ delta. Runs of unchanged 16 byte blocks are skipped.
+// Dropping the oldest entry when the ring is full needs no rebuilding of the others.
+
+#include "../libretro/libretro.h"
+#include "core.h"
+#include "core_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define REWIND_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define REWIND_NEON 1
+#endif
+
+#define REWIND_BLOCK   16 // delta granularity in bytes
+#define REWIND_MB      (1024 * 1024)
+
+// settings
+int core_rewind_seconds = 0; // 0 = off
+int core_rewind_memory = 32; // MB for the delta ring
+
+// held rewind button (core_input.c)
+bool core_rewind_held = false;
+
+// newest full state, and a buffer for the next one
+static uint8_t* rewind_state = NULL;
+static uint8_t* rewind_next = NULL;
+static uint32_t rewind_state_used = 0;
+static uint32_t rewind_next_used = 0;
+static bool rewind_state_valid = false;
+static uint32_t rewind_buffer_size = 0; // allocated size of state buffers (snapshot_size rounded to REWIND_BLOCK)
+
+// encoder output, worst case is larger than a state
+static uint8_t* rewind_scratch = NULL;
+
+// delta ring, entries are stored contiguously and wrap to the start when they don't fit
+static uint8_t* rewind_ring = NULL;
+static uint32_t rewind_ring_size = 0;
+static uint32_t* rewind_entry_pos = NULL;
+static uint32_t* rewind_entry_len = NULL;
+static int rewind_entry_max = 0;
+static int rewind_entry_first = 0; // oldest
+static int rewind_entry_count = 0;
+
+// settings the buffers were allocated for
+static int rewind_alloc_seconds = 0;
+static int rewind_alloc_memory = 0;
+
+// entry header
+struct rewind_header
+{
+	uint32_t length; // bytes covered by the delta, multiple of REWIND_BLOCK
+	uint32_t used; // used bytes of the previous state
+};
+
+//
+// vectorized block compare and XOR
+//
+
+static inline bool block_equal(const uint8_t* a, const uint8_t* b)
+{
+#if REWIND_SSE2
+	__m128i va = _mm_loadu_si128((const __m128i*)a);
+	__m128i vb = _mm_loadu_si128((const __m128i*)b);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(va,vb)) == 0xFFFF;
+#elif REWIND_NEON
+	uint64x2_t x = vreinterpretq_u64_u8(veorq_u8(vld1q_u8(a),vld1q_u8(b)));
+	return (vgetq_lane_u64(x,0) | vgetq_lane_u64(x,1)) == 0;
+#else
+	uint64_t a0, a1, b0, b1;
+	memcpy(&a0,a,8); memcpy(&a1,a+8,8);
+	memcpy(&b0,b,8); memcpy(&b1,b+8,8);
+	return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+#endif
+}
+
+static inline void block_xor(uint8_t* d, const uint8_t* a, const uint8_t* b)
+{
+#if REWIND_SSE2
+	__m128i va = _mm_loadu_si128((const __m128i*)a);
+	__m128i vb = _mm_loadu_si128((const __m128i*)b);
+	_mm_storeu_si128((__m128i*)d,_mm_xor_si128(va,vb));
+#elif REWIND_NEON
+	vst1q_u8(d,veorq_u8(vld1q_u8(a),vld1q_u8(b)));
+#else
+	uint64_t a0, a1, b0, b1;
+	memcpy(&a0,a,8); memcpy(&a1,a+8,8);
+	memcpy(&b0,b,8); memcpy(&b1,b+8,8);
+	a0 ^= b0; a1 ^= b1;
+	memcpy(d,&a0,8); memcpy(d+8,&a1,8);
+#endif
+}
+
+// Delta encoding: a series of runs, each is:
+//   uint32_t skip blocks (unchanged)
+//   uint32_t copy blocks (changed)
+//   copy * REWIND_BLOCK bytes of XOR data
+// until length / REWIND_BLOCK blocks are covered.
+
+static uint32_t rewind_encode(uint8_t* out, const uint8_t* a, const uint8_t* b, uint32_t length)
+{
+	const uint32_t blocks = length / REWIND_BLOCK;
+	uint8_t* o = out;
+	uint32_t i = 0;
+	while (i < blocks)
+	{
+		uint32_t skip = i;
+		while (i < blocks && block_equal(a+(i*REWIND_BLOCK),b+(i*REWIND_BLOCK))) ++i;
+		skip = i - skip;
+		uint32_t copy = i;
+		while (i < blocks && !block_equal(a+(i*REWIND_BLOCK),b+(i*REWIND_BLOCK))) ++i;
+		copy = i - copy;
+		memcpy(o,&skip,4);
+		memcpy(o+4,&copy,4);
+		o += 8;
+		for (uint32_t j = i - copy; j < i; ++j, o += REWIND_BLOCK)
+			block_xor(o,a+(j*REWIND_BLOCK),b+(j*REWIND_BLOCK));
+	}
+	return (uint32_t)(o - out);
+}
+
+static void rewind_decode(uint8_t* d, const uint8_t* in, uint32_t length)
+{
+	const uint32_t blocks = length / REWIND_BLOCK;
+	uint32_t i = 0;
+	while (i < blocks)
+	{
+		uint32_t skip, copy;
+		memcpy(&skip,in,4);
+		memcpy(&copy,in+4,4);
+		in += 8;
+		i += skip;
+		for (; copy > 0; --copy, ++i, in += REWIND_BLOCK)
+			block_xor(d+(i*REWIND_BLOCK),d+(i*REWIND_BLOCK),in);
+	}
+}
+
+//
+// ring management
+//
+
+static uint32_t rewind_worst_case(uint32_t size)
+{
+	// alternating single skip/copy blocks
+	uint32_t blocks = size / REWIND_BLOCK;
+	return sizeof(struct rewind_header) + size + (((blocks / 2) + 1) * 8);
+}
+
+void core_rewind_reset(void)
+{
+	rewind_state_valid = false;
+	rewind_entry_first = 0;
+	rewind_entry_count = 0;
+}
+
+void core_rewind_free(void)
+{
+	free(rewind_state); rewind_state = NULL;
+	free(rewind_next); rewind_next = NULL;
+	free(rewind_scratch); rewind_scratch = NULL;
+	free(rewind_ring); rewind_ring = NULL;
+	free(rewind_entry_pos); rewind_entry_pos = NULL;
+	free(rewind_entry_len); rewind_entry_len = NULL;
+	rewind_buffer_size = 0;
+	rewind_ring_size = 0;
+	rewind_entry_max = 0;
+	rewind_alloc_seconds = 0;
+	rewind_alloc_memory = 0;
+	core_rewind_reset();
+}
+
+static bool rewind_alloc(void)
+{
+	uint32_t size = (uint32_t)retro_serialize_size();
+	if (size % REWIND_BLOCK) size += REWIND_BLOCK - (size % REWIND_BLOCK);
+	if (rewind_ring &&
+		rewind_buffer_size == size &&
+		rewind_alloc_seconds == core_rewind_seconds &&
+		rewind_alloc_memory == core_rewind_memory)
+		return true;
+
+	core_rewind_free();
+	rewind_buffer_size = size;
+	rewind_ring_size = (uint32_t)core_rewind_memory * REWIND_MB;
+	rewind_entry_max = core_rewind_seconds * (core_video_fps > 0 ? core_video_fps : 60);
+	rewind_state = malloc(size);
+	rewind_next = malloc(size);
+	rewind_scratch = malloc(rewind_worst_case(size));
+	rewind_ring = malloc(rewind_ring_size);
+	rewind_entry_pos = malloc(sizeof(uint32_t) * rewind_entry_max);
+	rewind_entry_len = malloc(sizeof(uint32_t) * rewind_entry_max);
+	if (!rewind_state || !rewind_next || !rewind_scratch || !rewind_ring || !rewind_entry_pos || !rewind_entry_len)
+	{
+		core_error_printf("Unable to allocate rewind buffer: %d MB\n",core_rewind_memory);
+		core_rewind_free();
+		core_rewind_seconds = 0; // don't retry every frame
+		return false;
+	}
+	// state buffers are kept zero past their used size, so a delta only needs to cover the larger state
+	memset(rewind_state,0,size);
+	memset(rewind_next,0,size);
+	rewind_state_used = 0;
+	rewind_next_used = 0;
+	rewind_alloc_seconds = core_rewind_seconds;
+	rewind_alloc_memory = core_rewind_memory;
+	return true;
+}
+
+static void rewind_drop_oldest(void)
+{
+	rewind_entry_first = (rewind_entry_first + 1) % rewind_entry_max;
+	--rewind_entry_count;
+}
+
+static bool rewind_overlaps_oldest(uint32_t pos, uint32_t len)
+{
+	uint32_t p = rewind_entry_pos[rewind_entry_first];
+	uint32_t l = rewind_entry_len[rewind_entry_first];
+	return (pos < (p + l)) && (p < (pos + len));
+}
+
+static void rewind_push(const uint8_t* data, uint32_t len)
+{
+	uint32_t pos = 0;
+	if (len > rewind_ring_size)
+	{
+		// a single delta doesn't fit, history can't continue past this point
+		rewind_entry_count = 0;
+		return;
+	}
+	if (rewind_entry_count >= rewind_entry_max)
+		rewind_drop_oldest();
+	if (rewind_entry_count > 0)
+	{
+		int newest = (rewind_entry_first + rewind_entry_count - 1) % rewind_entry_max;
+		pos = rewind_entry_pos[newest] + rewind_entry_len[newest];
+		if ((pos + len) > rewind_ring_size)
+		{
+			// wrap: everything left past the newest entry is older, and will be overwritten
+			while (rewind_entry_count > 0 && rewind_entry_pos[rewind_entry_first] >= pos)
+				rewind_drop_oldest();
+			pos = 0;
+		}
+		while (rewind_entry_count > 0 && rewind_overlaps_oldest(pos,len))
+			rewind_drop_oldest();
+	}
+	if (rewind_entry_count == 0)
+	{
+		rewind_entry_first = 0;
+		pos = 0;
+	}
+	int e = (rewind_entry_first + rewind_entry_count) % rewind_entry_max;
+	memcpy(rewind_ring+pos,data,len);
+	rewind_entry_pos[e] = pos;
+	rewind_entry_len[e] = len;
+	++rewind_entry_count;
+}
+
+//
+// public
+//
+
+void core_rewind_capture(void)
+{
+	if (core_rewind_seconds <= 0)
+	{
+		if (rewind_ring) core_rewind_free();
+		return;
+	}
+	if (!rewind_alloc()) return;
+
+	uint32_t next_used = 0;
+	bool valid = core_serialize_rewind(rewind_next,true,&next_used);
+	if (next_used < rewind_next_used) // clear what's left of the last state in this buffer
+		memset(rewind_next+next_used,0,rewind_next_used-next_used);
+	rewind_next_used = next_used;
+	if (!valid)
+		return;
+	if (!rewind_state_valid)
+	{
+		// first state, nothing to compare with
+		uint8_t* swap = rewind_state;
+		rewind_state = rewind_next;
+		rewind_next = swap;
+		rewind_next_used = rewind_state_used;
+		rewind_state_used = next_used;
+		rewind_state_valid = true;
+		return;
+	}
+
+	// delta covers both states, then state buffers swap so the new one is kept in full
+	struct rewind_header h;
+	h.length = (next_used > rewind_state_used) ? next_used : rewind_state_used;
+	if (h.length % REWIND_BLOCK) h.length += REWIND_BLOCK - (h.length % REWIND_BLOCK);
+	h.used = rewind_state_used;
+	memcpy(rewind_scratch,&h,sizeof(h));
+	uint32_t len = sizeof(h) + rewind_encode(rewind_scratch+sizeof(h),rewind_next,rewind_state,h.length);
+	rewind_push(rewind_scratch,len);
+
+	uint8_t* swap = rewind_state;
+	rewind_state = rewind_next;
+	rewind_next = swap;
+	rewind_next_used = rewind_state_used;
+	rewind_state_used = next_used;
+}
+
+bool core_rewind_step(void)
+{
+	if (!rewind_ring || !rewind_state_valid) return false;
+	if (rewind_entry_count > 0)
+	{
+		// reconstruct the previous state in place
+		int newest = (rewind_entry_first + rewind_entry_count - 1) % rewind_entry_max;
+		const uint8_t* entry = rewind_ring + rewind_entry_pos[newest];
+		struct rewind_header h;
+		memcpy(&h,entry,sizeof(h));
+		rewind_decode(rewind_state,entry+sizeof(h),h.length);
+		rewind_state_used = h.used;
+		--rewind_entry_count;
+	}
+	// at the end of the history, stays on the oldest state
+	if (!core_serialize_rewind(rewind_state,false,NULL))
+	{
+		core_rewind_reset();
+		return false;
+	}
+	return true;
+}
@@ -126,6 +126,9 @@ void Cart_ResetImage(void)
 {
 	/* "Clear" cartridge ROM space */
 	memset(&RomMem[0xfa0000], 0xff, 0x20000);
+#ifdef __LIBRETRO__
+	STMemory_RomChanged();
+#endif
 
 	/* Print a warning if user tries to use an external cartridge file
 	 * together with something else requiring cartridge code:
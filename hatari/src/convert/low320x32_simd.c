@@ -0,0 +1,52 @@
+/*
+  Hatari - low320x32_simd.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Screen Conversion, Low Res to 320x32Bit (SIMD, see simd.h)
+*/
+
+CONVERT_SIMD_TARGET
+static void ConvertLowRes_320x32Bit_Simd(void)
+{
+	Uint32 *edi, *ebp;
+	Uint32 *esi;
+	Uint32 eax;
+	ConvertSimdPalette pal;
+	int y, x, update;
+
+	Convert_StartFrame();            /* Start frame, track palettes */
+
+	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
+	{
+
+		eax = STScreenLineOffset[y] + STScreenLeftSkipBytes;  /* Offset for this line + Amount to skip on left hand side */
+		edi = (Uint32 *)((Uint8 *)pSTScreen + eax);       /* ST format screen 4-plane 16 colors */
+		ebp = (Uint32 *)((Uint8 *)pSTScreenCopy + eax);   /* Previous ST format screen */
+		esi = (Uint32 *)pPCScreenDest;                    /* PC format screen */
+
+		update = AdjustLinePaletteRemap(y) & PALETTEMASK_UPDATEMASK;
+		ConvertSimd_SetPalette(&pal, STRGBPalette);
+
+		x = STScreenWidthBytes>>3; /* Amount to draw across in 16-pixels (8 bytes) */
+
+		do    /* x-loop */
+		{
+			/* Do 16 pixels at one time */
+			if (update || *edi!=*ebp || *(edi+1)!=*(ebp+1))    /* Does differ? */
+			{
+				bScreenContentsChanged = true;
+				ConvertSimd_Plot16(esi, ConvertSimd_LowPixels((const Uint8 *)edi), &pal);
+			}
+
+			esi += 16;                        /* Next PC pixels */
+			edi += 2;                         /* Next ST pixels */
+			ebp += 2;                         /* Next ST copy pixels */
+		}
+		while (--x);                      /* Loop on X */
+
+		/* Offset to next line: */
+		pPCScreenDest = (((Uint8 *)pPCScreenDest)+PCScreenBytesPerLine);
+	}
+}
@@ -0,0 +1,63 @@
+/*
+  Hatari - med640x32_simd.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Screen Conversion, Medium Res to 640x32Bit (SIMD, see simd.h)
+*/
+
+CONVERT_SIMD_TARGET
+static void ConvertMediumRes_640x32Bit_Simd(void)
+{
+	Uint32 *PCScreen = (Uint32 *)pPCScreenDest;
+	Uint32 *edi, *ebp;
+	Uint32 *esi;
+	Uint32 eax;
+	int y;
+
+	Convert_StartFrame();            /* Start frame, track palettes */
+
+	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
+	{
+
+		eax = STScreenLineOffset[y] + STScreenLeftSkipBytes;  /* Offset for this line + Amount to skip on left hand side */
+		edi = (Uint32 *)((Uint8 *)pSTScreen + eax);        /* ST format screen 4-plane 16 colors */
+		ebp = (Uint32 *)((Uint8 *)pSTScreenCopy + eax);    /* Previous ST format screen */
+		esi = PCScreen;                                    /* PC format screen */
+
+		if (AdjustLinePaletteRemap(y) & 0x00030000)        /* Change palette table */
+			Line_ConvertMediumRes_640x32Bit_Simd(edi, ebp, esi);
+		else
+			Line_ConvertLowRes_640x32Bit_Simd(edi, ebp, esi);
+
+		PCScreen = Double_ScreenLine32(PCScreen, PCScreenBytesPerLine);
+	}
+}
+
+
+CONVERT_SIMD_TARGET
+static void Line_ConvertMediumRes_640x32Bit_Simd(Uint32 *edi, Uint32 *ebp, Uint32 *esi)
+{
+	ConvertSimdPalette pal;
+	int x, update;
+
+	x = STScreenWidthBytes >> 2;   /* Amount to draw across in 16-pixels (4 bytes) */
+	update = ScrUpdateFlag & PALETTEMASK_UPDATEMASK;
+	ConvertSimd_SetPalette(&pal, STRGBPalette);
+
+	do  /* x-loop */
+	{
+		/* Do 16 pixels at one time */
+		if (update || *edi != *ebp)      /* Does differ? */
+		{
+			bScreenContentsChanged = true;
+			ConvertSimd_Plot16(esi, ConvertSimd_MedPixels((const Uint8 *)edi), &pal);
+		}
+
+		esi += 16;                      /* Next PC pixels */
+		edi += 1;                       /* Next ST pixels */
+		ebp += 1;                       /* Next ST copy pixels */
+	}
+	while (--x);                        /* Loop on X */
+}
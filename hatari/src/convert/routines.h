@@ -19,5 +19,12 @@ static void Line_ConvertMediumRes_640x32Bit(Uint32 *edi, Uint32 *ebp, Uint32 *es
 static void ConvertMediumRes_640x32Bit(void);
 static void Line_ConvertMediumRes_640x32Bit_Spec(Uint32 *edi, Uint32 *ebp, Uint32 *esi, Uint32 eax);
 static void ConvertMediumRes_640x32Bit_Spec(void);
+#if defined(__LIBRETRO__) && CONVERT_SIMD
+static void ConvertLowRes_320x32Bit_Simd(void);
+static void Line_ConvertLowRes_640x32Bit_Simd(Uint32 *edi, Uint32 *ebp, Uint32 *esi);
+static void ConvertLowRes_640x32Bit_Simd(void);
+static void Line_ConvertMediumRes_640x32Bit_Simd(Uint32 *edi, Uint32 *ebp, Uint32 *esi);
+static void ConvertMediumRes_640x32Bit_Simd(void);
+#endif
 
 #endif /* HATARI_CONVERTROUTINES_H */
@@ -0,0 +1,197 @@
+/*
+  Hatari - simd.h
+
+  SIMD kernels for the ST low/medium resolution screen conversion routines.
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  hatariB: each kernel converts one 16 pixel block, which is exactly one
+  128-bit vector of 8-bit colour indices:
+   - ConvertSimd_LowPixels / ConvertSimd_MedPixels transpose 4 or 2 bitplane
+     words (68000 byte order) into 16 indices.
+   - ConvertSimd_Plot16 looks up the 16 indices in the line palette with
+     byte shuffles of the palette split into byte planes
+     (ConvertSimd_SetPalette), and stores 16 pixels of 32 bits.
+
+  x86 uses SSSE3 (pshufb), compiled with a target attribute and selected at
+  runtime with ConvertSimd_Available(). AArch64 always has NEON.
+  Other hosts use the scalar routines in macros.h.
+*/
+
+#ifndef HATARI_CONVERTSIMD_H
+#define HATARI_CONVERTSIMD_H
+
+#include <stdbool.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+# define CONVERT_SIMD 1
+# define CONVERT_SIMD_SSSE3 1
+# define CONVERT_SIMD_TARGET __attribute__((target("ssse3")))
+# include <tmmintrin.h>
+#elif defined(__aarch64__) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+# define CONVERT_SIMD 1
+# define CONVERT_SIMD_NEON 1
+# define CONVERT_SIMD_TARGET
+# include <arm_neon.h>
+#else
+# define CONVERT_SIMD 0
+#endif
+
+#if CONVERT_SIMD_SSSE3
+
+typedef __m128i ConvertSimdPixels;
+typedef struct { __m128i b[4]; } ConvertSimdPalette;
+
+static inline bool ConvertSimd_Available(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3");
+}
+
+/* byte k of each 32-bit palette entry gathered into b[k] */
+CONVERT_SIMD_TARGET
+static inline void ConvertSimd_SetPalette(ConvertSimdPalette *pal, const Uint32 *palette)
+{
+	const __m128i group = _mm_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15);
+	__m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(palette+ 0)), group);
+	__m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(palette+ 4)), group);
+	__m128i p2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(palette+ 8)), group);
+	__m128i p3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(palette+12)), group);
+	__m128i t0 = _mm_unpacklo_epi32(p0, p1);
+	__m128i t1 = _mm_unpacklo_epi32(p2, p3);
+	__m128i t2 = _mm_unpackhi_epi32(p0, p1);
+	__m128i t3 = _mm_unpackhi_epi32(p2, p3);
+	pal->b[0] = _mm_unpacklo_epi64(t0, t1);
+	pal->b[1] = _mm_unpackhi_epi64(t0, t1);
+	pal->b[2] = _mm_unpacklo_epi64(t2, t3);
+	pal->b[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* one bitplane: pixel i (MSB first) set -> value in lane i */
+CONVERT_SIMD_TARGET
+static inline __m128i ConvertSimd_Plane(__m128i words, __m128i spread, __m128i value)
+{
+	const __m128i bit = _mm_setr_epi8(-128,64,32,16,8,4,2,1, -128,64,32,16,8,4,2,1);
+	__m128i plane = _mm_and_si128(_mm_shuffle_epi8(words, spread), bit);
+	return _mm_and_si128(_mm_cmpeq_epi8(plane, bit), value);
+}
+
+/* 16 low resolution pixels: 4 plane words */
+CONVERT_SIMD_TARGET
+static inline ConvertSimdPixels ConvertSimd_LowPixels(const Uint8 *planes)
+{
+	__m128i w = _mm_loadl_epi64((const __m128i *)planes);
+	__m128i idx;
+	idx =                    ConvertSimd_Plane(w, _mm_setr_epi8(0,0,0,0,0,0,0,0, 1,1,1,1,1,1,1,1), _mm_set1_epi8(1));
+	idx = _mm_or_si128(idx, ConvertSimd_Plane(w, _mm_setr_epi8(2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3), _mm_set1_epi8(2)));
+	idx = _mm_or_si128(idx, ConvertSimd_Plane(w, _mm_setr_epi8(4,4,4,4,4,4,4,4, 5,5,5,5,5,5,5,5), _mm_set1_epi8(4)));
+	idx = _mm_or_si128(idx, ConvertSimd_Plane(w, _mm_setr_epi8(6,6,6,6,6,6,6,6, 7,7,7,7,7,7,7,7), _mm_set1_epi8(8)));
+	return idx;
+}
+
+/* 16 medium resolution pixels: 2 plane words */
+CONVERT_SIMD_TARGET
+static inline ConvertSimdPixels ConvertSimd_MedPixels(const Uint8 *planes)
+{
+	int words;
+	__m128i w, idx;
+	memcpy(&words, planes, 4);
+	w = _mm_cvtsi32_si128(words);
+	idx =                    ConvertSimd_Plane(w, _mm_setr_epi8(0,0,0,0,0,0,0,0, 1,1,1,1,1,1,1,1), _mm_set1_epi8(1));
+	idx = _mm_or_si128(idx, ConvertSimd_Plane(w, _mm_setr_epi8(2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3), _mm_set1_epi8(2)));
+	return idx;
+}
+
+CONVERT_SIMD_TARGET
+static inline void ConvertSimd_Plot16(Uint32 *dst, ConvertSimdPixels idx, const ConvertSimdPalette *pal)
+{
+	__m128i b0 = _mm_shuffle_epi8(pal->b[0], idx);
+	__m128i b1 = _mm_shuffle_epi8(pal->b[1], idx);
+	__m128i b2 = _mm_shuffle_epi8(pal->b[2], idx);
+	__m128i b3 = _mm_shuffle_epi8(pal->b[3], idx);
+	__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+	__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+	__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+	__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+	_mm_storeu_si128((__m128i *)(dst+ 0), _mm_unpacklo_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dst+ 4), _mm_unpackhi_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dst+ 8), _mm_unpacklo_epi16(hi01, hi23));
+	_mm_storeu_si128((__m128i *)(dst+12), _mm_unpackhi_epi16(hi01, hi23));
+}
+
+/* 16 pixels, each doubled horizontally */
+CONVERT_SIMD_TARGET
+static inline void ConvertSimd_Plot16Double(Uint32 *dst, ConvertSimdPixels idx, const ConvertSimdPalette *pal)
+{
+	ConvertSimd_Plot16(dst,    _mm_unpacklo_epi8(idx, idx), pal);
+	ConvertSimd_Plot16(dst+16, _mm_unpackhi_epi8(idx, idx), pal);
+}
+
+#elif CONVERT_SIMD_NEON
+
+typedef uint8x16_t ConvertSimdPixels;
+typedef uint8x16x4_t ConvertSimdPalette;
+
+static inline bool ConvertSimd_Available(void)
+{
+	return true;
+}
+
+static inline void ConvertSimd_SetPalette(ConvertSimdPalette *pal, const Uint32 *palette)
+{
+	*pal = vld4q_u8((const uint8_t *)palette);
+}
+
+#define CONVERT_SIMD_PLANE(w_, lo_, hi_, value_) \
+	vandq_u8(vtstq_u8(vcombine_u8(vdup_lane_u8(w_, lo_), vdup_lane_u8(w_, hi_)), bit), vdupq_n_u8(value_))
+
+static inline ConvertSimdPixels ConvertSimd_LowPixels(const Uint8 *planes)
+{
+	static const uint8_t bits[16] = { 128,64,32,16,8,4,2,1, 128,64,32,16,8,4,2,1 };
+	const uint8x16_t bit = vld1q_u8(bits);
+	uint8x8_t w = vld1_u8(planes);
+	uint8x16_t idx;
+	idx =               CONVERT_SIMD_PLANE(w, 0, 1, 1);
+	idx = vorrq_u8(idx, CONVERT_SIMD_PLANE(w, 2, 3, 2));
+	idx = vorrq_u8(idx, CONVERT_SIMD_PLANE(w, 4, 5, 4));
+	idx = vorrq_u8(idx, CONVERT_SIMD_PLANE(w, 6, 7, 8));
+	return idx;
+}
+
+static inline ConvertSimdPixels ConvertSimd_MedPixels(const Uint8 *planes)
+{
+	static const uint8_t bits[16] = { 128,64,32,16,8,4,2,1, 128,64,32,16,8,4,2,1 };
+	const uint8x16_t bit = vld1q_u8(bits);
+	uint32_t words;
+	uint8x8_t w;
+	uint8x16_t idx;
+	memcpy(&words, planes, 4);
+	w = vreinterpret_u8_u32(vdup_n_u32(words));
+	idx =               CONVERT_SIMD_PLANE(w, 0, 1, 1);
+	idx = vorrq_u8(idx, CONVERT_SIMD_PLANE(w, 2, 3, 2));
+	return idx;
+}
+
+#undef CONVERT_SIMD_PLANE
+
+static inline void ConvertSimd_Plot16(Uint32 *dst, ConvertSimdPixels idx, const ConvertSimdPalette *pal)
+{
+	uint8x16x4_t px;
+	px.val[0] = vqtbl1q_u8(pal->val[0], idx);
+	px.val[1] = vqtbl1q_u8(pal->val[1], idx);
+	px.val[2] = vqtbl1q_u8(pal->val[2], idx);
+	px.val[3] = vqtbl1q_u8(pal->val[3], idx);
+	vst4q_u8((uint8_t *)dst, px);
+}
+
+static inline void ConvertSimd_Plot16Double(Uint32 *dst, ConvertSimdPixels idx, const ConvertSimdPalette *pal)
+{
+	ConvertSimd_Plot16(dst,    vzip1q_u8(idx, idx), pal);
+	ConvertSimd_Plot16(dst+16, vzip2q_u8(idx, idx), pal);
+}
+
+#endif /* CONVERT_SIMD_NEON */
+
+#endif /* HATARI_CONVERTSIMD_H */
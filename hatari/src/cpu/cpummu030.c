@@ -98,6 +98,12 @@ struct mmufastcache030
 	uae_u32 log;
 	uae_u32 phys;
 	uae_u8 cs;
+#ifdef __LIBRETRO__
+	/* hatariB: host pointer to the physical page when it is plain RAM/ROM, see mmu030_cache_host() */
+	uae_u8 stram;
+	addrbank *bank;
+	uae_u8 *host;
+#endif
 };
 static struct mmufastcache030 atc_data_cache_read[MMUFASTCACHE_ENTRIES030];
 static struct mmufastcache030 atc_data_cache_write[MMUFASTCACHE_ENTRIES030];
@@ -1904,6 +1910,22 @@ bool mmu030_is_super_access(bool read)
 	}
 }
 
+#if MMU_DPAGECACHE030 && defined(__LIBRETRO__)
+/* hatariB: remember where the physical page lives in host memory, so a data page cache hit */
+/* can skip x_phys_*() and the bank lookup. Only for banks memory_get_*() would also access directly. */
+static void mmu030_cache_set_host(struct mmufastcache030 *c, uaecptr phys, bool write)
+{
+	addrbank *ab = &get_mem_bank(phys);
+	uae_u8 *base = write ? ab->baseaddr_direct_w : ab->baseaddr_direct_r;
+
+	c->bank = ab;
+	c->host = NULL;
+	c->stram = base && base == STmem_fast_base;
+	if (base)
+		c->host = base + ((phys - ab->startaccessmask) & ab->mask);
+}
+#endif
+
 static void mmu030_add_data_read_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 {
 #if MMU_DPAGECACHE030
@@ -1913,6 +1935,9 @@ static void mmu030_add_data_read_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 		atc_data_cache_read[idx2].log = idx1;
 		atc_data_cache_read[idx2].phys = phys;
 		atc_data_cache_read[idx2].cs = mmu030_cache_state;
+#ifdef __LIBRETRO__
+		mmu030_cache_set_host(&atc_data_cache_read[idx2], phys, false);
+#endif
 	}
 #endif
 }
@@ -1926,6 +1951,9 @@ static void mmu030_add_data_write_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 		atc_data_cache_write[idx2].log = idx1;
 		atc_data_cache_write[idx2].phys = phys;
 		atc_data_cache_write[idx2].cs = mmu030_cache_state;
+#ifdef __LIBRETRO__
+		mmu030_cache_set_host(&atc_data_cache_write[idx2], phys, true);
+#endif
 	}
 #endif
 }
@@ -2099,6 +2127,24 @@ STATIC_INLINE void cacheablecheck(uaecptr addr)
 	}
 }
 
+#if MMU_DPAGECACHE030 && defined(__LIBRETRO__)
+/* hatariB: host address for a data page cache hit, or NULL to go through x_phys_*(). */
+/* Cycle exact mode needs the bus timing of the x_phys_*() functions, and the bank is */
+/* checked again in case the memory map changed since the entry was added. */
+STATIC_INLINE uae_u8 *mmu030_cache_host(struct mmufastcache030 *c, uaecptr addr, int size)
+{
+	uae_u32 page_index = addr & mmu030.translation.page.mask;
+
+	if (!c->host || currprefs.cpu_memory_cycle_exact
+		|| page_index > mmu030.translation.page.mask - (size - 1)
+		|| &get_mem_bank(c->phys) != c->bank)
+		return NULL;
+	mmu030_cache_state = c->cs;
+	cacheablecheck(c->phys);
+	return c->host + page_index;
+}
+#endif
+
 void mmu030_put_long(uaecptr addr, uae_u32 val, uae_u32 fc)
 {
  	mmu030_cache_state = CACHE_ENABLE_ALL;
@@ -2107,6 +2153,15 @@ void mmu030_put_long(uaecptr addr, uae_u32 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_write[idx2], addr, 4);
+			if (p) {
+				if (atc_data_cache_write[idx2].stram)
+					STMEMORY_DIRTY(p - STmem_fast_base, 4);
+				do_put_mem_long(p, val);
+				return;
+			}
+#endif
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2133,6 +2188,15 @@ void mmu030_put_word(uaecptr addr, uae_u16 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_write[idx2], addr, 2);
+			if (p) {
+				if (atc_data_cache_write[idx2].stram)
+					STMEMORY_DIRTY(p - STmem_fast_base, 2);
+				do_put_mem_word(p, val);
+				return;
+			}
+#endif
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2159,6 +2223,15 @@ void mmu030_put_byte(uaecptr addr, uae_u8 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_write[idx2], addr, 1);
+			if (p) {
+				if (atc_data_cache_write[idx2].stram)
+					STMEMORY_DIRTY(p - STmem_fast_base, 1);
+				*p = val;
+				return;
+			}
+#endif
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2186,6 +2259,11 @@ uae_u32 mmu030_get_long(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_read[idx2], addr, 4);
+			if (p)
+				return do_get_mem_long(p);
+#endif
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2213,6 +2291,11 @@ uae_u16 mmu030_get_word(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_read[idx2], addr, 2);
+			if (p)
+				return do_get_mem_word(p);
+#endif
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2240,6 +2323,11 @@ uae_u8 mmu030_get_byte(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+#ifdef __LIBRETRO__
+			uae_u8 *p = mmu030_cache_host(&atc_data_cache_read[idx2], addr, 1);
+			if (p)
+				return *p;
+#endif
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2663,6 +2751,18 @@ void mmu030_reset(int hardreset)
 	mmu030_set_funcs();
 }
 
+#ifdef __LIBRETRO__
+/* hatariB: the ATC and the page caches are not part of the savestate, and restore_cpu_extra() */
+/* only restores the raw TT0/TT1 registers. Decode them again and drop stale translations. */
+void mmu030_restore_state(void)
+{
+	mmu030.transparent.tt0 = mmu030_decode_tt(tt0_030);
+	mmu030.transparent.tt1 = mmu030_decode_tt(tt1_030);
+	tt_enabled = (tt0_030 & TT_ENABLE) || (tt1_030 & TT_ENABLE);
+	mmu030_flush_atc_all();
+}
+#endif
+
 void mmu030_set_funcs(void)
 {
 	if (currprefs.mmu_model != 68030)
@@ -38,6 +38,10 @@ static int illegal_count;
 
 static uae_u32 STmem_size;
 uae_u32 TTmem_size = 0;
+#ifdef __LIBRETRO__
+uae_u8 *STmem_fast_base = NULL;		/* hatariB: inline ST RAM fast path, see memory.h */
+uae_u32 STmem_fast_size = 0;
+#endif
 static uae_u32 TTmem_mask;
 
 #define STmem_start  0x00000000
@@ -580,6 +584,7 @@ static void REGPARAM3 STmem_lput(uaecptr addr, uae_u32 l)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	STMEMORY_DIRTY(addr, 4);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -587,6 +592,7 @@ static void REGPARAM3 STmem_wput(uaecptr addr, uae_u32 w)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	STMEMORY_DIRTY(addr, 2);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -594,6 +600,7 @@ static void REGPARAM3 STmem_bput(uaecptr addr, uae_u32 b)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	STMEMORY_DIRTY(addr, 1);
 	STmemory[addr] = b;
 }
 
@@ -642,6 +649,7 @@ static void REGPARAM3 STmem_lput_MMU(uaecptr addr, uae_u32 l)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 4);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -650,6 +658,7 @@ static void REGPARAM3 STmem_wput_MMU(uaecptr addr, uae_u32 w)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 2);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -658,6 +667,7 @@ static void REGPARAM3 STmem_bput_MMU(uaecptr addr, uae_u32 b)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 1);
 	STmemory[addr] = b;
 }
 
@@ -733,6 +743,7 @@ static void REGPARAM3 SysMem_lput(uaecptr addr, uae_u32 l)
 		return;
 	}
 
+	STMEMORY_DIRTY(addr, 4);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -758,6 +769,7 @@ static void REGPARAM3 SysMem_wput(uaecptr addr, uae_u32 w)
 		}
 	}
 
+	STMEMORY_DIRTY(addr, 2);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -774,6 +786,7 @@ static void REGPARAM3 SysMem_bput(uaecptr addr, uae_u32 b)
 		return;
 	}
 
+	STMEMORY_DIRTY(addr, 1);
 	STmemory[addr] = b;
 }
 
@@ -845,6 +858,7 @@ static void REGPARAM3 SysMem_lput_MMU(uaecptr addr, uae_u32 l)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 4);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -871,6 +885,7 @@ static void REGPARAM3 SysMem_wput_MMU(uaecptr addr, uae_u32 w)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 2);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -888,6 +903,7 @@ static void REGPARAM3 SysMem_bput_MMU(uaecptr addr, uae_u32 b)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	STMEMORY_DIRTY(addr, 1);
 	STmemory[addr] = b;
 }
 
@@ -1630,6 +1646,19 @@ void memory_map_Standard_RAM ( uint32_t MMU_Bank0_Size , uint32_t MMU_Bank1_Size
 		map_banks_ce(&SysMem_bank, 0x00, 0x10000 >> 16, 0, CE_MEMBANK_CHIP16, CACHE_ENABLE_BOTH);
 		map_banks_ce(&STmem_bank, 0x10000 >> 16, ( STmem_size - 0x10000 ) >> 16, 0, CE_MEMBANK_CHIP16, CACHE_ENABLE_BOTH);
 	}
+
+#ifdef __LIBRETRO__
+	/* hatariB: STmem_bank is now mapped from $10000 to the end of ST RAM, and on ST/STE */
+	/* nothing else is mapped over it, so get_word/put_word/... can access it directly */
+	STmem_fast_base = STmemory;
+	STmem_fast_size = 0;
+	if ( ( Config_IsMachineST() || Config_IsMachineSTE() )
+	  && mem_banks[ STMEM_FAST_START >> 16 ] == &STmem_bank
+	  && STmem_size > STMEM_FAST_START + 3 )
+	{
+		STmem_fast_size = STmem_size - STMEM_FAST_START - 3;
+	}
+#endif
 }
 
 
@@ -1855,6 +1884,10 @@ void memory_init(uae_u32 NewSTMemSize, uae_u32 NewTTMemSize, uae_u32 NewRomMemSt
  */
 void memory_uninit (void)
 {
+#ifdef __LIBRETRO__
+	STmem_fast_base = NULL;
+	STmem_fast_size = 0;
+#endif
 	/* Here, we free allocated memory from memory_init */
 	if (TTmemory) {
 		free(TTmemory);
@@ -2089,6 +2122,10 @@ void memory_put_long(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab == &STmem_bank)
+			STMEMORY_DIRTY(addr, 4);
+#endif
 		do_put_mem_long((uae_u32*)m, v);
 	}
 }
@@ -2102,6 +2139,10 @@ void memory_put_word(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab == &STmem_bank)
+			STMEMORY_DIRTY(addr, 2);
+#endif
 		do_put_mem_word((uae_u16*)m, v);
 	}
 }
@@ -2115,6 +2156,10 @@ void memory_put_byte(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab == &STmem_bank)
+			STMEMORY_DIRTY(addr, 1);
+#endif
 		*m = (uae_u8)v;
 	}
 }
@@ -555,24 +555,66 @@ uae_u32 memory_get_byte(uaecptr);
 uae_u32 memory_get_longi(uaecptr);
 uae_u32 memory_get_wordi(uaecptr);
 
+#ifdef __LIBRETRO__
+/* hatariB: ST RAM pages written since the last savestate, for incremental savestates */
+#define	STMEMORY_DIRTY_SHIFT	12
+#define	STMEMORY_DIRTY_PAGES	( ( 16*1024*1024 ) >> STMEMORY_DIRTY_SHIFT )
+extern uint8_t STMemory_Dirty[STMEMORY_DIRTY_PAGES];
+/* offset into STRam, len <= page size */
+#define	STMEMORY_DIRTY(offset_,len_) do { \
+	STMemory_Dirty[ ( (offset_) >> STMEMORY_DIRTY_SHIFT ) & ( STMEMORY_DIRTY_PAGES-1 ) ] = 1; \
+	STMemory_Dirty[ ( ( (offset_)+(len_)-1 ) >> STMEMORY_DIRTY_SHIFT ) & ( STMEMORY_DIRTY_PAGES-1 ) ] = 1; } while (0)
+
+/* hatariB: inline fast path for ST RAM on ST/STE. memory_map_Standard_RAM() sets STmem_fast_size */
+/* when $10000 to the end of ST RAM is mapped to STmem_bank without MMU translation, */
+/* so the CPU can access it directly instead of through mem_banks[] and memory_get_*(). */
+/* STmem_fast_size is 0 on other machines or mappings, and leaves 3 bytes so a long access stays inside. */
+#define	STMEM_FAST_START	0x10000
+extern uae_u8 *STmem_fast_base;
+extern uae_u32 STmem_fast_size;
+#define	STMEM_FAST(addr_)	( (uae_u32)( (addr_) - STMEM_FAST_START ) < STmem_fast_size )
+#else
+#define	STMEMORY_DIRTY(offset_,len_) do { } while (0)
+#endif
+
 STATIC_INLINE uae_u32 get_long(uaecptr addr)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+		return do_get_mem_long(STmem_fast_base + addr);
+#endif
 	return memory_get_long(addr);
 }
 STATIC_INLINE uae_u32 get_word (uaecptr addr)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+		return do_get_mem_word(STmem_fast_base + addr);
+#endif
 	return memory_get_word(addr);
 }
 STATIC_INLINE uae_u32 get_byte (uaecptr addr)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+		return STmem_fast_base[addr];
+#endif
 	return memory_get_byte(addr);
 }
 STATIC_INLINE uae_u32 get_longi(uaecptr addr)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+		return do_get_mem_long(STmem_fast_base + addr);
+#endif
 	return memory_get_longi(addr);
 }
 STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+		return do_get_mem_word(STmem_fast_base + addr);
+#endif
 	return memory_get_wordi(addr);
 }
 
@@ -704,14 +746,38 @@ void memory_put_byte(uaecptr, uae_u32);
 
 STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+	{
+		STMEMORY_DIRTY(addr, 4);
+		do_put_mem_long(STmem_fast_base + addr, l);
+		return;
+	}
+#endif
 	memory_put_long(addr, l);
 }
 STATIC_INLINE void put_word (uaecptr addr, uae_u32 w)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+	{
+		STMEMORY_DIRTY(addr, 2);
+		do_put_mem_word(STmem_fast_base + addr, w);
+		return;
+	}
+#endif
 	memory_put_word(addr, w);
 }
 STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
 {
+#ifdef __LIBRETRO__
+	if (STMEM_FAST(addr))
+	{
+		STMEMORY_DIRTY(addr, 1);
+		STmem_fast_base[addr] = b;
+		return;
+	}
+#endif
 	memory_put_byte(addr, b);
 }
 
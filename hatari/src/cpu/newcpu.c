@@ -5414,6 +5414,312 @@ static void out_cd32io (uae_u32 pc)
 
 #endif
 
+#ifdef __LIBRETRO__
+/* hatariB: idle loop skip for the 68000 run loops.
+ * A short loop that branches back to its start with no memory writes, reading only RAM or ROM,
+ * can't change its state until the next CycInt event fires. The same applies to the STOP instruction,
+ * which is executed again every 4 cycles while waiting for an interrupt.
+ * Once two iterations in a row have left the CPU state unchanged without any event,
+ * every further iteration that would complete before the next event is skipped
+ * by adding its cycles to the counters directly.
+ * The result is the same as interpreting them, so this is safe with savestates and netplay.
+ * Reads from IO (e.g. $FF8209 or MFP timers) are not skipped, as their value depends on the cycle. */
+
+extern bool core_idle_skip;
+extern uint64_t core_idle_skip_cycles;
+
+#define IDLE_LOOP_MAX_BYTES  32
+
+typedef struct {
+	uae_u32 regs[16];
+	struct flag_struct flags;
+	uint64_t event;
+	evt_t ipl_pin_change_evt;
+	int ipl[2], ipl_pin, ipl_pin_p;
+	int last_family, last_cycles;
+	int stopped;
+	uae_u16 db, read_buffer, write_buffer, phase;
+} idle_loop_state;
+
+static bool idle_loop_watch;
+static uaecptr idle_loop_head, idle_loop_end;
+static uaecptr idle_loop_reject_head, idle_loop_reject_end;
+static int idle_loop_match;
+static idle_loop_state idle_loop_last;
+static uint64_t idle_loop_clock, idle_loop_delta;
+static evt_t idle_loop_currcycle, idle_loop_dcurrcycle;
+static int idle_loop_icount, idle_loop_dicount;
+
+static void idle_loop_reset(void)
+{
+	idle_loop_watch = false;
+	idle_loop_reject_head = idle_loop_reject_end = 0;
+}
+
+/* reads with no side effects and no dependency on the cycle counter */
+static bool idle_loop_readable(uaecptr addr, int size)
+{
+	addr &= 0xffffff;
+	if (addr + size <= STRamEnd)
+		return true;
+	return (addr >= TosAddress) && (addr + size <= TosAddress + TosSize);
+}
+
+/* bytes of extension words for a read-only effective address, -1 if not allowed */
+static int idle_loop_ea(uaecptr ext, int ea, int size)
+{
+	int reg = ea & 7;
+	int len;
+	uaecptr addr;
+
+	switch ((ea >> 3) & 7)
+	{
+	case 0: /* Dn */
+	case 1: /* An */
+		return 0;
+	case 2: /* (An) */
+		addr = m68k_areg(regs, reg);
+		len = 0;
+		break;
+	case 5: /* d16(An) */
+		addr = m68k_areg(regs, reg) + (uae_s16)get_word(ext);
+		len = 2;
+		break;
+	case 7:
+		switch (reg)
+		{
+		case 0: /* abs.w */
+			addr = (uae_s16)get_word(ext);
+			len = 2;
+			break;
+		case 1: /* abs.l */
+			addr = get_long(ext);
+			len = 4;
+			break;
+		case 2: /* d16(PC) */
+			addr = ext + (uae_s16)get_word(ext);
+			len = 2;
+			break;
+		case 4: /* #imm */
+			return (size == 4) ? 4 : 2;
+		default:
+			return -1;
+		}
+		break;
+	default: /* (An)+, -(An) and indexed modes */
+		return -1;
+	}
+	return idle_loop_readable(addr, size) ? len : -1;
+}
+
+/* length of an instruction that only reads memory and writes at most a data register, 0 if not allowed */
+static int idle_loop_insn(uaecptr pc)
+{
+	uae_u16 op = get_word(pc);
+	int opmode = (op >> 6) & 7;
+	int len;
+
+	if (op == 0x4e71) /* NOP */
+		return 2;
+	if ((op & 0xf100) == 0x7000) /* MOVEQ */
+		return 2;
+	if ((op & 0xff00) == 0x4a00 && opmode < 3) /* TST */
+		len = idle_loop_ea(pc + 2, op & 63, 1 << opmode);
+	else if ((op & 0xf000) == 0xb000 && (opmode < 4 || opmode == 7)) /* CMP, CMPA */
+		len = idle_loop_ea(pc + 2, op & 63, (opmode == 3) ? 2 : (opmode == 7) ? 4 : (1 << opmode));
+	else if ((op & 0xff00) == 0x0c00 && opmode < 3) /* CMPI */
+	{
+		int imm = (opmode == 2) ? 4 : 2;
+		len = idle_loop_ea(pc + 2 + imm, op & 63, 1 << opmode);
+		if (len >= 0)
+			len += imm;
+	}
+	else if ((op & 0xffc0) == 0x0800) /* BTST #n */
+	{
+		len = idle_loop_ea(pc + 4, op & 63, 1);
+		if (len >= 0)
+			len += 2;
+	}
+	else if ((op & 0xf1c0) == 0x0100 && (op & 0x38) != 0x08) /* BTST Dn (not MOVEP) */
+		len = idle_loop_ea(pc + 2, op & 63, 1);
+	else if ((op & 0xc000) == 0 && (op & 0x3000) && (op & 0x01c0) == 0) /* MOVE <ea>,Dn */
+	{
+		int size = (op >> 12) & 3;
+		len = idle_loop_ea(pc + 2, op & 63, (size == 1) ? 1 : (size == 3) ? 2 : 4);
+	}
+	else if (((op & 0xf000) == 0xc000 || (op & 0xf000) == 0x8000) && opmode < 3) /* AND, OR <ea>,Dn */
+		len = idle_loop_ea(pc + 2, op & 63, 1 << opmode);
+	else
+		return 0;
+	return (len < 0) ? 0 : (2 + len);
+}
+
+/* straight line of allowed instructions from head, ending with a Bcc/BRA back to head at end, or a STOP */
+static bool idle_loop_verify(uaecptr head, uaecptr end)
+{
+	uaecptr pc = head;
+	uae_u16 op;
+	int disp;
+
+	if (!idle_loop_readable(head, end + 8 - head)) /* including prefetch past the branch */
+		return false;
+	while (pc < end)
+	{
+		int len = idle_loop_insn(pc);
+		if (!len)
+			return false;
+		pc += len;
+	}
+	if (pc != end)
+		return false;
+	op = get_word(end);
+	if (op == 0x4e72 && head == end) /* STOP waits by executing itself again */
+		return true;
+	if ((op & 0xf000) != 0x6000 || (op & 0x0f00) == 0x0100) /* Bcc or BRA, not BSR */
+		return false;
+	disp = (uae_s8)(op & 0xff);
+	if (disp == 0)
+		disp = (uae_s16)get_word(end + 2);
+	else if (disp == -1)
+		return false;
+	return (end + 2 + disp) == head;
+}
+
+static void idle_loop_snapshot(idle_loop_state *s)
+{
+	memset(s, 0, sizeof(*s));
+	memcpy(s->regs, regs.regs, sizeof(s->regs));
+	s->flags = regflags;
+	s->event = CycInt_ActiveInt_Cycles;
+	s->ipl_pin_change_evt = regs.ipl_pin_change_evt;
+	s->ipl[0] = regs.ipl[0];
+	s->ipl[1] = regs.ipl[1];
+	s->ipl_pin = regs.ipl_pin;
+	s->ipl_pin_p = regs.ipl_pin_p;
+	s->last_family = LastOpcodeFamily;
+	s->last_cycles = LastInstrCycles;
+	s->stopped = regs.stopped;
+	s->db = regs.db;
+	s->read_buffer = regs.read_buffer;
+	s->write_buffer = regs.write_buffer;
+	s->phase = (CyclesGlobalClockCounter + currcycle * 2 / CYCLE_UNIT) & 3;
+}
+
+/* the loop branched back to its head */
+static void idle_loop_visit(void)
+{
+	idle_loop_state s;
+	uint64_t delta = CyclesGlobalClockCounter - idle_loop_clock;
+	evt_t dcurrcycle = currcycle - idle_loop_currcycle;
+	int dicount = regs.instruction_cnt - idle_loop_icount;
+
+	idle_loop_snapshot(&s);
+	if (memcmp(&s, &idle_loop_last, sizeof(s)) || delta != idle_loop_delta || dcurrcycle != idle_loop_dcurrcycle)
+	{
+		idle_loop_match = 0;
+		idle_loop_last = s;
+	}
+	/* SPCFLAG_CHECK is never cleared in Hatari, and has no effect */
+	else if (++idle_loop_match >= 2 && !(regs.spcflags & ~SPCFLAG_CHECK) && !BlitterPhase && !bDspEnabled && delta > 0)
+	{
+		/* skip the iterations that end before the next event */
+		uint64_t now = CyclesGlobalClockCounter << CYCINT_SHIFT;
+		if (CycInt_ActiveInt_Cycles > now)
+		{
+			uint64_t skip = (CycInt_ActiveInt_Cycles - now - 1) / (delta << CYCINT_SHIFT);
+			if (skip > 0)
+			{
+				CyclesGlobalClockCounter += skip * delta;
+				nCyclesMainCounter += (int)(skip * delta);
+				currcycle += skip * dcurrcycle;
+				regs.instruction_cnt += (int)skip * dicount;
+				core_idle_skip_cycles += skip * delta;
+			}
+		}
+	}
+	idle_loop_delta = delta;
+	idle_loop_dcurrcycle = dcurrcycle;
+	idle_loop_clock = CyclesGlobalClockCounter;
+	idle_loop_currcycle = currcycle;
+	idle_loop_icount = regs.instruction_cnt;
+}
+
+/* a short backward branch was taken */
+static void idle_loop_begin(uaecptr head, uaecptr end)
+{
+	if (head == idle_loop_reject_head && end == idle_loop_reject_end)
+		return;
+	if (!idle_loop_verify(head, end))
+	{
+		idle_loop_reject_head = head;
+		idle_loop_reject_end = end;
+		return;
+	}
+	idle_loop_watch = true;
+	idle_loop_head = head;
+	idle_loop_end = end;
+	idle_loop_match = 0;
+	idle_loop_delta = 0;
+	idle_loop_dcurrcycle = 0;
+	idle_loop_snapshot(&idle_loop_last);
+	idle_loop_clock = CyclesGlobalClockCounter;
+	idle_loop_currcycle = currcycle;
+	idle_loop_icount = regs.instruction_cnt;
+}
+
+/* after each instruction */
+STATIC_INLINE void idle_loop_check(void)
+{
+	uaecptr pc = m68k_getpc();
+	if (idle_loop_watch)
+	{
+		if (pc - idle_loop_head > idle_loop_end - idle_loop_head) /* left the loop, or an exception */
+			idle_loop_watch = false;
+		else if (pc == idle_loop_head)
+			idle_loop_visit();
+	}
+	else if (pc <= regs.instruction_pc && regs.instruction_pc - pc <= IDLE_LOOP_MAX_BYTES)
+	{
+		idle_loop_begin(pc, regs.instruction_pc);
+	}
+}
+#endif
+
+#if defined(__LIBRETRO__) && CORE_PREDECODE_TEST
+/* hatariB: the predecode cache prototype for m68k_run_1 (see DEVELOP.md, CPU Predecode Cache).
+ * Only built with make PREDECODE_TEST=1, for make bench to report its hit rate and frame time.
+ * A direct-mapped cache of the handler for each instruction address. An entry whose opcode
+ * no longer matches the prefetched one is a miss, which stands in for invalidating it on writes. */
+
+extern uint64_t core_predecode_hits;
+extern uint64_t core_predecode_misses;
+
+#define PREDECODE_ENTRIES  4096
+
+typedef struct {
+	uaecptr pc;
+	uae_u32 opcode;
+	cpuop_func *handler;
+} predecode_entry;
+
+static predecode_entry predecode_cache[PREDECODE_ENTRIES];
+
+STATIC_INLINE cpuop_func *predecode_lookup(uaecptr pc, uae_u32 opcode)
+{
+	predecode_entry *e = &predecode_cache[(pc >> 1) & (PREDECODE_ENTRIES - 1)];
+	if (e->handler && e->pc == pc && e->opcode == opcode)
+	{
+		++core_predecode_hits;
+		return e->handler;
+	}
+	++core_predecode_misses;
+	e->pc = pc;
+	e->opcode = opcode;
+	e->handler = cpufunctbl[opcode];
+	return e->handler;
+}
+#endif
+
 #ifndef CPUEMU_11
 
 static void m68k_run_1 (void)
@@ -5433,6 +5739,12 @@ static void m68k_run_1 (void)
 #ifdef WINUAE_FOR_HATARI
 	Log_Printf(LOG_DEBUG, "m68k_run_1\n");
 	CpuRunFuncNoret = false;
+#endif
+#ifdef __LIBRETRO__
+	idle_loop_reset();
+#if CORE_PREDECODE_TEST
+	memset(predecode_cache, 0, sizeof(predecode_cache)); /* cpufunctbl may have been rebuilt */
+#endif
 #endif
 
 	while (!exit) {
@@ -5474,7 +5786,11 @@ static void m68k_run_1 (void)
 #endif
 
 				r->instruction_pc = m68k_getpc ();
+#if defined(__LIBRETRO__) && CORE_PREDECODE_TEST
+				cpu_cycles = (*predecode_lookup(r->instruction_pc, r->opcode))(r->opcode) & 0xffff;
+#else
 				cpu_cycles = (*cpufunctbl[r->opcode])(r->opcode) & 0xffff;
+#endif
 				if (!regs.loop_mode)
 					regs.ird = regs.opcode;
 				cpu_cycles = adjust_cycles (cpu_cycles);
@@ -5507,6 +5823,10 @@ static void m68k_run_1 (void)
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
+#ifdef __LIBRETRO__
+				if (core_idle_skip && !exit)
+					idle_loop_check();
+#endif
 
 				if (!currprefs.cpu_compatible || (currprefs.cpu_cycle_exact && currprefs.cpu_model <= 68010))
 					exit = true;
@@ -5545,6 +5865,9 @@ static void m68k_run_1_ce (void)
 	CpuRunCycleExact = true;
 	CpuRunFuncNoret = true;
 #endif
+#ifdef __LIBRETRO__
+	idle_loop_reset();
+#endif
 
 	while (!exit) {
 		check_debugger();
@@ -5689,6 +6012,10 @@ cont:
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
+#ifdef __LIBRETRO__
+				if (core_idle_skip && !exit)
+					idle_loop_check();
+#endif
 
 				if (!currprefs.cpu_cycle_exact || currprefs.cpu_model > 68010)
 					exit = true;
@@ -7718,6 +8045,9 @@ void m68k_go_frame(bool run)
 				memory_map_dump ();
 #endif
 				if (currprefs.mmu_model == 68030) {
+#ifdef __LIBRETRO__
+					mmu030_restore_state (); /* hatariB: TT registers and stale ATC */
+#endif
 					mmu030_decode_tc (tc_030, true);
 				} else if (currprefs.mmu_model >= 68040) {
 					mmu_set_tc (regs.tcr);
@@ -7908,6 +8238,8 @@ void m68k_go_frame(bool run)
 		Log_Printf(LOG_DEBUG, "exit m68k_run\n");
 	}
 #ifdef __LIBRETRO__
+	/* hatariB: run any DSP cycles still owed by DSP_Run in lazy mode, so the frame ends in the same state */
+	DSP_CatchUp();
 }
 void m68k_go_quit(void)
 {
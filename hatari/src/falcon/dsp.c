@@ -60,6 +60,12 @@ static const char* x_ext_memory_addr_name[] = {
 };
 
 static int32_t save_cycles;
+
+#ifdef __LIBRETRO__
+extern bool core_dsp_lazy; // hatarib_dsp_lazy option
+static bool dsp_lazy_owed = false; // save_cycles holds cycles that DSP_Run left for DSP_CatchUp
+static bool dsp_in_run = false; // DSP instructions are being executed, don't catch up recursively
+#endif
 #endif
 
 static bool bDspDebugging;
@@ -177,6 +183,9 @@ void DSP_UnInit(void)
 void DSP_Reset(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core_reset();
 	DSP_TriggerHostInterrupt ( 0 );				/* Clear HREQ */
 	save_cycles = 0;
@@ -205,6 +214,9 @@ void DSP_Enable(void)
 void DSP_Disable(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	bDspEnabled = false;
 #endif
 }
@@ -216,6 +228,15 @@ void DSP_Disable(void)
 void DSP_MemorySnapShot_Capture(bool bSave)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	if (bSave)
+		DSP_CatchUp();
+	else
+	{
+		dsp_lazy_owed = false;
+		dsp56k_clear_decode_cache();
+	}
+#endif
 	MemorySnapShot_Store(&bDspEnabled, sizeof(bDspEnabled));
 	MemorySnapShot_Store(&dsp_core, sizeof(dsp_core));
 	MemorySnapShot_Store(&save_cycles, sizeof(save_cycles));
@@ -246,6 +267,21 @@ void DSP_Run(int nHostCycles)
 	if (save_cycles <= 0)
 		return;
 
+#ifdef __LIBRETRO__
+	/* hatariB: in lazy mode, leave the owed cycles in save_cycles until DSP_CatchUp. */
+	/* The DSP only has to keep pace when it can interrupt the CPU (host port RREQ/TREQ), */
+	/* or start a handshake mode DMA transfer through port C. */
+	if (core_dsp_lazy && !bDspDebugging
+	    && !(dsp_core.hostport[CPU_HOST_ICR] & ((1<<CPU_HOST_ICR_RREQ)|(1<<CPU_HOST_ICR_TREQ)))
+	    && !(dsp_core.periph[DSP_SPACE_X][DSP_PCDDR] & 0x30))
+	{
+		dsp_lazy_owed = true;
+		return;
+	}
+	dsp_lazy_owed = false;
+	dsp_in_run = true;
+#endif
+
 	if (unlikely(bDspDebugging))
 	{
 		while (save_cycles > 0)
@@ -264,9 +300,39 @@ void DSP_Run(int nHostCycles)
 			save_cycles -= dsp_core.instr_cycle;
 		}
 	}
+#ifdef __LIBRETRO__
+	dsp_in_run = false;
+#endif
+
+#endif
+}
 
+#ifdef __LIBRETRO__
+/**
+ * hatariB: run the DSP cycles left owing by DSP_Run in lazy mode.
+ * This must be called before anything outside the DSP reads or changes
+ * its state (host port, SSI, reset, savestate), and at the end of each frame.
+ * The DSP then executes the same instructions as when run after every
+ * CPU instruction, but in longer batches. Cycles saved while the DSP is
+ * not running are left for DSP_Run, as before.
+ */
+void DSP_CatchUp(void)
+{
+#if ENABLE_DSP_EMU
+	if (!dsp_lazy_owed || dsp_in_run)
+		return;
+
+	dsp_lazy_owed = false;
+	dsp_in_run = true;
+	while (save_cycles > 0)
+	{
+		dsp56k_execute_instruction();
+		save_cycles -= dsp_core.instr_cycle;
+	}
+	dsp_in_run = false;
 #endif
 }
+#endif
 
 /**
  * Enable/disable DSP debugging mode
@@ -756,6 +822,9 @@ bool DSP_Disasm_SetRegister(const char *arg, uint32_t value)
 uint32_t DSP_SsiReadTxValue(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	return dsp_core.ssi.transmit_value;
 #else
 	return 0;
@@ -768,6 +837,9 @@ uint32_t DSP_SsiReadTxValue(void)
 void DSP_SsiWriteRxValue(uint32_t value)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core.ssi.received_value = value & 0xffffff;
 #endif
 }
@@ -779,6 +851,9 @@ void DSP_SsiWriteRxValue(uint32_t value)
 void DSP_SsiReceive_SC0(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core_ssi_Receive_SC0();
 #endif
 }
@@ -792,6 +867,9 @@ void DSP_SsiTransmit_SC0(void)
 void DSP_SsiReceive_SC1(uint32_t FrameCounter)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core_ssi_Receive_SC1(FrameCounter);
 #endif
 }
@@ -806,6 +884,9 @@ void DSP_SsiTransmit_SC1(void)
 void DSP_SsiReceive_SC2(uint32_t FrameCounter)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core_ssi_Receive_SC2(FrameCounter);
 #endif
 }
@@ -820,6 +901,9 @@ void DSP_SsiTransmit_SC2(uint32_t frame)
 void DSP_SsiReceive_SCK(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	dsp_core_ssi_Receive_SCK();
 #endif
 }
@@ -841,6 +925,9 @@ void DSP_HandleReadAccess(void)
 	uint8_t value;
 	bool multi_access = false;
 
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	for (addr = IoAccessBaseAddress; addr < IoAccessBaseAddress+nIoMemAccessSize; addr++)
 	{
 #if ENABLE_DSP_EMU
@@ -868,6 +955,9 @@ void DSP_HandleWriteAccess(void)
 	uint32_t addr;
 	bool multi_access = false;
 
+#ifdef __LIBRETRO__
+	DSP_CatchUp();
+#endif
 	for (addr = IoAccessBaseAddress; addr < IoAccessBaseAddress+nIoMemAccessSize; addr++)
 	{
 #if ENABLE_DSP_EMU
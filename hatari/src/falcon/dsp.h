@@ -42,6 +42,9 @@ extern void DSP_Reset(void);
 extern void DSP_Enable(void);
 extern void DSP_Disable(void);
 extern void DSP_Run(int nHostCycles);
+#ifdef __LIBRETRO__
+extern void DSP_CatchUp(void);
+#endif
 
 /* Save Dsp state to snapshot */
 extern void DSP_MemorySnapShot_Capture(bool bSave);
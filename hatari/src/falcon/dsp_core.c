@@ -1122,6 +1122,9 @@ void dsp_core_write_host(int addr, uint8_t value)
 					(dsp_core.hostport[CPU_HOST_TXH]<<16) |
 					(dsp_core.hostport[CPU_HOST_TXM]<<8) |
 					 dsp_core.hostport[CPU_HOST_TXL];
+#ifdef __LIBRETRO__
+				dsp56k_invalidate_decode(dsp_core.bootstrap_pos);
+#endif
 
 				LOG_TRACE(TRACE_DSP_STATE, "Dsp: bootstrap p:0x%04x = 0x%06x\n",
 								dsp_core.bootstrap_pos,
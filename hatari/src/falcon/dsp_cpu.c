@@ -117,12 +117,26 @@ static bool isDsp_in_disasm_mode;
 static char   str_disasm_memory[2][50]; 	/* Buffer for memory change text in disasm mode */
 static uint16_t disasm_memory_ptr;		/* Pointer for memory change in disasm mode */
 
+#ifdef __LIBRETRO__
+/* hatariB: decoded instruction cache, one handler per P address (hatarib_dsp_cache option) */
+/* Internal P RAM at 0-$1ff, then the external RAM, cleared on reset and invalidated on P writes */
+#define DSP_DECODE_CACHE_SIZE	(0x200 + DSP_RAMSIZE)
+#define DSP_DECODE_CACHE_INDEX(address_)	(((address_) < 0x200) ? (address_) : (0x200 + ((address_) & (DSP_RAMSIZE-1))))
+extern bool core_dsp_cache;
+extern uint32_t core_dsp_cache_hits;
+extern uint32_t core_dsp_cache_misses;
+#endif
+
 /**********************************
  *	Functions
  **********************************/
 
 typedef void (*dsp_emul_t)(void);
 
+#ifdef __LIBRETRO__
+static dsp_emul_t dsp_decode_cache[DSP_DECODE_CACHE_SIZE];
+#endif
+
 static void dsp_postexecute_update_pc(void);
 static void dsp_postexecute_interrupts(void);
 
@@ -707,6 +721,9 @@ void dsp56k_init_cpu(void)
 {
 	dsp56k_disasm_init();
 	isDsp_in_disasm_mode = false;
+#ifdef __LIBRETRO__
+	dsp56k_clear_decode_cache();
+#endif
 #if DSP_COUNT_IPS
 	start_time = SDL_GetTicks();
 	num_inst = 0;
@@ -751,6 +768,49 @@ uint16_t dsp56k_execute_one_disasm_instruction(FILE *out, uint16_t pc)
 	return instruction_length;
 }
 
+#ifdef __LIBRETRO__
+void dsp56k_clear_decode_cache(void)
+{
+	memset(dsp_decode_cache, 0, sizeof(dsp_decode_cache));
+}
+
+void dsp56k_invalidate_decode(uint16_t address)
+{
+	dsp_decode_cache[DSP_DECODE_CACHE_INDEX(address)] = NULL;
+}
+
+/* hatariB: the handler that dsp56k_execute_instruction would reach for this instruction, */
+/* going through the dsp_pm_2 and dsp_pm_4 tests once instead of every time */
+static dsp_emul_t dsp56k_decode(uint32_t inst)
+{
+	uint32_t value;
+
+	if (inst < 0x100000) {
+		value = (inst >> 11) & (BITMASK(6) << 3);
+		value += (inst >> 5) & BITMASK(3);
+		return opcodes8h[value];
+	}
+
+	switch ((inst>>20) & BITMASK(4)) {
+		case 2:
+			/* No parallel move, only the ALU instruction */
+			if ((inst & 0xffff00) == 0x200000)
+				return opcodes_alu[inst & BITMASK(8)];
+			/* R update */
+			if ((inst & 0xffe000) == 0x204000)
+				return dsp_pm_2;
+			if ((inst & 0xfc0000) == 0x200000)
+				return dsp_pm_2_2;
+			return dsp_pm_3;
+		case 4:
+			if ((inst & 0xf40000) == 0x400000)
+				return dsp_pm_4x;
+			return dsp_pm_5;
+	}
+	return opcodes_parmove[(inst>>20) & BITMASK(4)];
+}
+#endif
+
 void dsp56k_execute_instruction(void)
 {
 	uint32_t value;
@@ -789,6 +849,18 @@ void dsp56k_execute_instruction(void)
 		}
 	}
 
+#ifdef __LIBRETRO__
+	if (core_dsp_cache && isDsp_in_disasm_mode == false) {
+		dsp_emul_t *handler = &dsp_decode_cache[DSP_DECODE_CACHE_INDEX(dsp_core.pc)];
+		if (*handler == NULL) {
+			*handler = dsp56k_decode(cur_inst);
+			++core_dsp_cache_misses;
+		} else {
+			++core_dsp_cache_hits;
+		}
+		(*handler)();
+	} else
+#endif
 	if (cur_inst < 0x100000) {
 		value = (cur_inst >> 11) & (BITMASK(6) << 3);
 		value += (cur_inst >> 5) & BITMASK(3);
@@ -1303,6 +1375,12 @@ static void write_memory_raw(int space, uint16_t address, uint32_t value)
 {
 	value &= BITMASK(24);
 
+#ifdef __LIBRETRO__
+	/* hatariB: every write to P memory (internal or external) forgets its decoded instruction */
+	if (space == DSP_SPACE_P)
+		dsp_decode_cache[DSP_DECODE_CACHE_INDEX(address)] = NULL;
+#endif
+
 	/* Peripheral address ? */
 	if (address >= 0xffc0) {
 		if (space == DSP_SPACE_X) {
@@ -1410,6 +1488,11 @@ static void write_memory_raw(int space, uint16_t address, uint32_t value)
 
 	/* Falcon: External RAM, map X,Y to P */
 	dsp_core.ramext[address & (DSP_RAMSIZE-1)] = value;
+#ifdef __LIBRETRO__
+	/* hatariB: X and Y external RAM is also P memory */
+	if (space != DSP_SPACE_P)
+		dsp_decode_cache[0x200 + (address & (DSP_RAMSIZE-1))] = NULL;
+#endif
 }
 
 static void write_memory_disasm(int space, uint16_t address, uint32_t value)
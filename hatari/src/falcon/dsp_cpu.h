@@ -114,6 +114,10 @@ extern "C" {
 extern void dsp56k_init_cpu(void);		/* Set dsp_core to use */
 extern void dsp56k_execute_instruction(void);	/* Execute 1 instruction */
 extern uint16_t dsp56k_execute_one_disasm_instruction(FILE *out, uint16_t pc);	/* Execute 1 instruction in disasm mode */
+#ifdef __LIBRETRO__
+extern void dsp56k_clear_decode_cache(void);	/* hatariB: forget all decoded instructions */
+extern void dsp56k_invalidate_decode(uint16_t address);	/* hatariB: P memory at address was written */
+#endif
 
 /* Interrupt relative functions */
 void dsp_set_interrupt(uint32_t intr, uint32_t set);
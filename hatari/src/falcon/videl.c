@@ -1023,6 +1023,14 @@ bool VIDEL_renderScreen(void)
 		return false;
 	}
 
+#ifdef __LIBRETRO__
+	if (core_video_skip) // hidden frame, but the savestated host palette must still be synced
+	{
+		VIDEL_UpdateColors();
+		return false;
+	}
+#endif
+
 	if (!Screen_Lock())
 		return false;
 
@@ -72,7 +72,25 @@ static void	Floppy_DriveTransitionSetState ( int Drive , int State );
 
 #ifdef __LIBRETRO__
 extern bool core_savestate_floppy_modify;
+extern bool core_disk_image(const char* filename, uint8_t** data, unsigned int* size);
+extern bool bCaptureError;
 static bool core_prevent_eject_save = false;
+
+/* Unmodified disk images can be stored in savestates as a reference, */
+/* recovered from the core's disk image cache or the originals kept below */
+static bool floppy_pristine[MAX_FLOPPYDRIVES];	/* pBuffer is unmodified since insertion */
+static uint64_t floppy_hash[MAX_FLOPPYDRIVES];	/* hash of the unmodified pBuffer */
+#define FLOPPY_ORIGINALS 4			/* unmodified images kept after their first write */
+static uint8_t *floppy_original[FLOPPY_ORIGINALS];
+static long floppy_original_size[FLOPPY_ORIGINALS];
+static uint64_t floppy_original_hash[FLOPPY_ORIGINALS];
+static int floppy_original_next = 0;
+static bool Floppy_RestoreReference(int Drive);
+
+/* Each insertion or write gives the drive a new serial, so a run-ahead restore */
+/* to this same instance can keep an image that has not changed since the save */
+static uint32_t floppy_serial[MAX_FLOPPYDRIVES];
+static uint32_t floppy_serial_next = 0;
 #endif
 
 /*-----------------------------------------------------------------------*/
@@ -101,6 +119,16 @@ void Floppy_Init(void)
 void Floppy_UnInit(void)
 {
 	Floppy_EjectBothDrives();
+#ifdef __LIBRETRO__
+	{
+		int i;
+		for (i = 0; i < FLOPPY_ORIGINALS; i++)
+		{
+			free(floppy_original[i]);
+			floppy_original[i] = NULL;
+		}
+	}
+#endif
 }
 
 
@@ -128,6 +156,26 @@ void Floppy_Reset(void)
 void Floppy_MemorySnapShot_Capture(bool bSave)
 {
 	int i;
+#ifdef __LIBRETRO__
+	uint8_t bSerial = core_snapshot_same_instance;
+	uint32_t Serial[MAX_FLOPPYDRIVES];
+	bool bKeep[MAX_FLOPPYDRIVES];
+
+	/* hatariB: a same instance restore keeps any drive whose image is unchanged since the save */
+	MemorySnapShot_Store(&bSerial, sizeof(bSerial));
+	for (i = 0; i < MAX_FLOPPYDRIVES; i++)
+	{
+		Serial[i] = floppy_serial[i];
+		if (bSerial)
+			MemorySnapShot_Store(&Serial[i], sizeof(Serial[i]));
+		/* IPF and STX captures rebuild their own state from the image buffer */
+		bKeep[i] = !bSave && bSerial && (Serial[i] == floppy_serial[i]) &&
+			( !EmulationDrives[i].bDiskInserted ||
+			  ( EmulationDrives[i].ImageType == FLOPPY_IMAGE_TYPE_ST ) ||
+			  ( EmulationDrives[i].ImageType == FLOPPY_IMAGE_TYPE_MSA ) ||
+			  ( EmulationDrives[i].ImageType == FLOPPY_IMAGE_TYPE_DIM ) );
+	}
+#endif
 
 	/* If restoring then eject old drives first! */
 	if (!bSave)
@@ -135,7 +183,11 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 	{
 		// if savety save is disabled, prevent the savestate restore write to disk
 		if (!core_savestate_floppy_modify) core_prevent_eject_save = true;
-		Floppy_EjectBothDrives();
+		for (i = 0; i < MAX_FLOPPYDRIVES; i++)
+		{
+			if (!bKeep[i])
+				Floppy_EjectDiskFromDrive(i);
+		}
 		core_prevent_eject_save = false;
 	}
 #else	
@@ -145,21 +197,61 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 	/* Save/Restore details */
 	for (i = 0; i < MAX_FLOPPYDRIVES; i++)
 	{
+#ifdef __LIBRETRO__
+		uint8_t bReference;
+#endif
 		MemorySnapShot_Store(&EmulationDrives[i].ImageType, sizeof(EmulationDrives[i].ImageType));
 		MemorySnapShot_Store(&EmulationDrives[i].bDiskInserted, sizeof(EmulationDrives[i].bDiskInserted));
 		MemorySnapShot_Store(&EmulationDrives[i].nImageBytes, sizeof(EmulationDrives[i].nImageBytes));
+#ifdef __LIBRETRO__
+		/* hatariB: unmodified disk contents can be stored as a hash reference instead */
+		MemorySnapShot_Store(&floppy_pristine[i], sizeof(floppy_pristine[i]));
+		MemorySnapShot_Store(&floppy_hash[i], sizeof(floppy_hash[i]));
+		bReference = core_snapshot_refs && floppy_pristine[i];
+		MemorySnapShot_Store(&bReference, sizeof(bReference));
+		if (bKeep[i])
+		{
+			/* pBuffer still holds the saved contents */
+			if (EmulationDrives[i].pBuffer && !bReference)
+				core_snapshot_skip(EmulationDrives[i].nImageBytes);
+			MemorySnapShot_StoreFilename(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
+			MemorySnapShot_Store(&EmulationDrives[i].bContentsChanged,sizeof(EmulationDrives[i].bContentsChanged));
+			MemorySnapShot_Store(&EmulationDrives[i].bOKToSave,sizeof(EmulationDrives[i].bOKToSave));
+			MemorySnapShot_Store(&EmulationDrives[i].TransitionState1,sizeof(EmulationDrives[i].TransitionState1));
+			MemorySnapShot_Store(&EmulationDrives[i].TransitionState1_VBL,sizeof(EmulationDrives[i].TransitionState1_VBL));
+			MemorySnapShot_Store(&EmulationDrives[i].TransitionState2,sizeof(EmulationDrives[i].TransitionState2));
+			MemorySnapShot_Store(&EmulationDrives[i].TransitionState2_VBL,sizeof(EmulationDrives[i].TransitionState2_VBL));
+			/* FDC_DRIVES[] was restored directly, as the drive was not ejected */
+			continue;
+		}
+#endif
 		if (!bSave && EmulationDrives[i].bDiskInserted)
 		{
 			EmulationDrives[i].pBuffer = malloc(EmulationDrives[i].nImageBytes);
 			if (!EmulationDrives[i].pBuffer)
 				perror("Floppy_MemorySnapShot_Capture");
 		}
+#ifndef __LIBRETRO__
 		if (EmulationDrives[i].pBuffer)
+#else
+		if (EmulationDrives[i].pBuffer && !bReference)
+#endif
 			MemorySnapShot_Store(EmulationDrives[i].pBuffer, EmulationDrives[i].nImageBytes);
 #ifndef __LIBRETRO__
 		MemorySnapShot_Store(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
 #else
 		MemorySnapShot_StoreFilename(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
+		if (!bSave && EmulationDrives[i].pBuffer && bReference && !Floppy_RestoreReference(i))
+		{
+			core_signal_error("Savestate floppy image not available: ", EmulationDrives[i].sFileName);
+			bCaptureError = true;
+			/* leave the drive empty rather than holding uninitialized data */
+			free(EmulationDrives[i].pBuffer);
+			EmulationDrives[i].pBuffer = NULL;
+			EmulationDrives[i].bDiskInserted = false;
+			EmulationDrives[i].ImageType = FLOPPY_IMAGE_TYPE_NONE;
+			floppy_pristine[i] = false;
+		}
 #endif
 		MemorySnapShot_Store(&EmulationDrives[i].bContentsChanged,sizeof(EmulationDrives[i].bContentsChanged));
 		MemorySnapShot_Store(&EmulationDrives[i].bOKToSave,sizeof(EmulationDrives[i].bOKToSave));
@@ -175,7 +267,12 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 #ifndef __LIBRETRO__
 			FDC_InsertFloppy ( i );
 #else
+		{
 			FDC_InsertFloppyRestore ( i ); // insertion resets some state that must be restored
+			floppy_serial[i] = ++floppy_serial_next;
+		}
+		else if (!bSave)
+			floppy_serial[i] = 0;
 #endif
 	}
 }
@@ -599,6 +696,93 @@ void core_floppy_changed(int drive)
 {
 	EmulationDrives[drive].bContentsChanged = true;
 }
+static void Floppy_KeepOriginal(int Drive)
+{
+	/* the first write to an unmodified image keeps a copy, so that savestates referencing it still work */
+	int i;
+	uint8_t *pCopy;
+
+	for (i = 0; i < FLOPPY_ORIGINALS; i++)
+	{
+		if (floppy_original[i] && floppy_original_hash[i] == floppy_hash[Drive]
+			&& floppy_original_size[i] == EmulationDrives[Drive].nImageBytes)
+			return;
+	}
+	pCopy = malloc(EmulationDrives[Drive].nImageBytes);
+	if (!pCopy)
+		return;
+	memcpy(pCopy, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
+	i = floppy_original_next;
+	floppy_original_next = (floppy_original_next + 1) % FLOPPY_ORIGINALS;
+	free(floppy_original[i]);
+	floppy_original[i] = pCopy;
+	floppy_original_size[i] = EmulationDrives[Drive].nImageBytes;
+	floppy_original_hash[i] = floppy_hash[Drive];
+}
+static bool Floppy_RestoreReference(int Drive)
+{
+	/* recover the referenced contents of a restored drive into its pBuffer */
+	long nImageBytes = 0;
+	int ImageType = FLOPPY_IMAGE_TYPE_NONE;
+	const char *filename = EmulationDrives[Drive].sFileName;
+	uint8_t *data;
+	unsigned int size;
+	uint8_t *pImage = NULL;
+	void *old_data, *old_extra_data;
+	unsigned int old_size, old_extra_size;
+	int old_read_drive;
+	int i;
+
+	/* originals kept from a modified disk */
+	for (i = 0; i < FLOPPY_ORIGINALS; i++)
+	{
+		if (floppy_original[i] && floppy_original_hash[i] == floppy_hash[Drive]
+			&& floppy_original_size[i] == EmulationDrives[Drive].nImageBytes)
+		{
+			memcpy(EmulationDrives[Drive].pBuffer, floppy_original[i], floppy_original_size[i]);
+			return true;
+		}
+	}
+
+	/* otherwise read it again from the core's disk image cache */
+	if (!core_disk_image(filename, &data, &size))
+		return false;
+	old_data = floppy_data[Drive];
+	old_size = floppy_size[Drive];
+	old_extra_data = floppy_extra_data[Drive];
+	old_extra_size = floppy_extra_size[Drive];
+	old_read_drive = floppy_read_drive;
+	floppy_data[Drive] = data;
+	floppy_size[Drive] = size;
+	floppy_extra_data[Drive] = NULL;
+	floppy_extra_size[Drive] = 0;
+	floppy_read_drive = Drive;
+	if (MSA_FileNameIsMSA(filename, true))
+		pImage = MSA_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+	else if (ST_FileNameIsST(filename, true))
+		pImage = ST_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+	else if (DIM_FileNameIsDIM(filename, true))
+		pImage = DIM_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+	else if (IPF_FileNameIsIPF(filename, true))
+		pImage = IPF_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+	else if (STX_FileNameIsSTX(filename, true))
+		pImage = STX_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+	floppy_data[Drive] = old_data;
+	floppy_size[Drive] = old_size;
+	floppy_extra_data[Drive] = old_extra_data;
+	floppy_extra_size[Drive] = old_extra_size;
+	floppy_read_drive = old_read_drive;
+
+	if (pImage && nImageBytes == EmulationDrives[Drive].nImageBytes
+		&& core_hash(pImage, nImageBytes) == floppy_hash[Drive])
+	{
+		memcpy(EmulationDrives[Drive].pBuffer, pImage, nImageBytes);
+		free(pImage);
+		return true;
+	}
+	free(pImage);
+	return false;
+}
 #endif
 
 /*-----------------------------------------------------------------------*/
@@ -690,6 +874,11 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 	EmulationDrives[Drive].nImageBytes = nImageBytes;
 	EmulationDrives[Drive].bDiskInserted = true;
 	EmulationDrives[Drive].bContentsChanged = false;
+#ifdef __LIBRETRO__
+	floppy_pristine[Drive] = true;
+	floppy_hash[Drive] = core_hash(EmulationDrives[Drive].pBuffer, nImageBytes);
+	floppy_serial[Drive] = ++floppy_serial_next;
+#endif
 
 	if ( ( ImageType == FLOPPY_IMAGE_TYPE_ST ) || ( ImageType == FLOPPY_IMAGE_TYPE_MSA )
 	  || ( ImageType == FLOPPY_IMAGE_TYPE_DIM ) )
@@ -788,6 +977,10 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 	EmulationDrives[Drive].ImageType = FLOPPY_IMAGE_TYPE_NONE;
 	EmulationDrives[Drive].nImageBytes = 0;
 	EmulationDrives[Drive].bDiskInserted = false;
+#ifdef __LIBRETRO__
+	floppy_pristine[Drive] = false;
+	floppy_serial[Drive] = 0;
+#endif
 #ifndef __LIBRETRO__
 	if (!core_prevent_eject_save)
 #endif
@@ -1075,6 +1268,14 @@ bool Floppy_WriteSectors(int Drive, uint8_t *pBuffer, uint16_t Sector,
 		Offset += (NUMBYTESPERSECTOR*(Sector-1));   /* And finally to sector */
 
 		/* Write sectors (usually 512 bytes per sector) */
+#ifdef __LIBRETRO__
+		if (floppy_pristine[Drive])
+		{
+			Floppy_KeepOriginal(Drive);
+			floppy_pristine[Drive] = false;
+		}
+		floppy_serial[Drive] = ++floppy_serial_next;
+#endif
 		memcpy(pDiskBuffer+Offset, pBuffer, (int)Count*NUMBYTESPERSECTOR);
 		/* And set 'changed' flag */
 		EmulationDrives[Drive].bContentsChanged = true;
@@ -3274,7 +3274,12 @@ static bool GemDOS_SNext(void)
 		{
 			/* older TOS versions zero file name if there are no (further) matches */
 			if (TosVersion < 0x0400)
+			{
 				pDTA->dta_name[0] = 0;
+#ifdef __LIBRETRO__
+				STMemory_DirtyRange(DTA_Gemdos, sizeof(DTA));
+#endif
+			}
 			Regs[REG_D0] = GEMDOS_ENMFIL;    /* No more files */
 			return true;
 		}
@@ -21,3 +21,8 @@ void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
 bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
                     int leftBorderSize, int rightBorderSize,
                     int upperBorderSize, int lowerBorderSize);
+
+#ifdef __LIBRETRO__
+void Screen_GenConvInvalidate(void);
+bool Screen_GenConvUnchanged(void);
+#endif
@@ -53,6 +53,7 @@ extern int	YmVolumeMixing;
 #define		YM2149_LPF_FILTER_PWM			2
 #ifdef __LIBRETRO__
 #define		YM2149_LPF_FILTER_IIR			3
+#define		YM2149_LPF_FILTER_SINC			4	/* replaces the resample method */
 #endif
 extern int	YM2149_LPF_Filter;
 
@@ -65,6 +66,10 @@ extern int	YM2149_HPF_Filter;
 #define		YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N	2
 extern int	YM2149_Resample_Method;
 
+#ifdef __LIBRETRO__
+extern bool	YM2149_Block_Kernel;
+#endif
+
 
 extern void Sound_Init(void);
 extern void Sound_Reset(void);
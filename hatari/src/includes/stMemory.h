@@ -28,6 +28,14 @@ extern uae_u32 TTmem_size;
 
 extern uint32_t STRamEnd;
 
+#ifdef __LIBRETRO__
+/* hatariB: ST RAM pages written since the last savestate, for incremental savestates */
+/* (STMemory_Dirty and STMEMORY_DIRTY are in cpu/memory.h, for its inline ST RAM writes) */
+extern bool STMemory_SkipClear;
+extern void STMemory_DirtyRange ( uint32_t addr , uint32_t len );
+extern void STMemory_RomChanged ( void );
+#endif
+
 
 #define	MEM_BANK_SIZE_128	( 128 * 1024 )		/* 00b */
 #define	MEM_BANK_SIZE_512	( 512 * 1024 )		/* 01b */
@@ -298,6 +298,7 @@ void IoMem_Init(void)
 	}
 
 	/* Now set the correct handlers */
+#ifndef __LIBRETRO__
 	for (addr=0xff8000; addr <= 0xffffff; addr++)
 	{
 		/* Does this hardware location/span appear in our list of possible intercepted functions? */
@@ -318,6 +319,28 @@ void IoMem_Init(void)
 			}
 		}
 	}
+#else
+	/* hatariB: visit the span of each entry, instead of searching the whole list for every address. */
+	/* This gives the same result, but is much faster (called for every savestate restore). */
+	for (i=0; pInterceptAccessFuncs[i].Address != 0; i++)
+	{
+		for (addr=pInterceptAccessFuncs[i].Address; addr < pInterceptAccessFuncs[i].Address+pInterceptAccessFuncs[i].SpanInBytes; addr++)
+		{
+			if (addr >= 0xff8000 && addr <= 0xffffff)
+			{
+				/* Security checks... */
+				if (pInterceptReadTable[addr-0xff8000] != IoMem_BusErrorEvenReadAccess && pInterceptReadTable[addr-0xff8000] != IoMem_BusErrorOddReadAccess)
+					Log_Printf(LOG_WARN, "IoMem_Init: $%x (R) already defined\n", addr);
+				if (pInterceptWriteTable[addr-0xff8000] != IoMem_BusErrorEvenWriteAccess && pInterceptWriteTable[addr-0xff8000] != IoMem_BusErrorOddWriteAccess)
+					Log_Printf(LOG_WARN, "IoMem_Init: $%x (W) already defined\n", addr);
+
+				/* This location needs to be intercepted, so add entry to list */
+				pInterceptReadTable[addr-0xff8000] = pInterceptAccessFuncs[i].ReadFunc;
+				pInterceptWriteTable[addr-0xff8000] = pInterceptAccessFuncs[i].WriteFunc;
+			}
+		}
+	}
+#endif
 
 	/* After the IO access handlers were set, some machines with common IoMemTable_xxx */
 	/* will require some extra changes (eg: ST vs MegaST, STE ve MegaSTE) */
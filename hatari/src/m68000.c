@@ -781,6 +781,10 @@ void	M68000_Flush_All_Caches ( uaecptr addr , int size )
 //fprintf ( stderr , "M68000_Flush_All_Caches\n" );
 	flush_cpu_caches(true);
 	invalidate_cpu_data_caches();
+#ifdef __LIBRETRO__
+	/* memory was modified directly */
+	STMemory_DirtyRange ( addr , size );
+#endif
 }
 
 
@@ -797,6 +801,10 @@ void	M68000_Flush_Data_Cache ( uaecptr addr , int size )
 //fprintf ( stderr , "M68000_Flush_Data_Cache\n" );
 	/* Data cache for cpu >= 68030 */
 	invalidate_cpu_data_caches();
+#ifdef __LIBRETRO__
+	/* memory was modified directly */
+	STMemory_DirtyRange ( addr , size );
+#endif
 }
 
 
@@ -510,7 +510,13 @@ void MemorySnapShot_Restore_Do(void)
 
 		/* Reset emulator to get things running */
 		IoMem_UnInit();  IoMem_Init();
+#ifdef __LIBRETRO__
+		STMemory_SkipClear = true; /* ST RAM is restored below */
+#endif
 		Reset_Cold();
+#ifdef __LIBRETRO__
+		STMemory_SkipClear = false;
+#endif
 
 		/* Capture each files details */
 	LIBRETRO_DEBUG_SNAPSHOT("STMemory");
@@ -585,6 +591,9 @@ void MemorySnapShot_Restore_Do(void)
 		MemorySnapShot_CloseFile();
 
 		/* changes may affect also info shown in statusbar */
+#ifdef __LIBRETRO__
+		if (!core_snapshot_lean) /* lean restore returns to a recent state with the same info */
+#endif
 		Statusbar_UpdateInfo();
 
 #ifndef __LIBRETRO__
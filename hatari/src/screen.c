@@ -40,6 +40,9 @@ const char Screen_fileid[] = "Hatari screen.c";
 #include "screen.h"
 #include "screenConvert.h"
 #include "control.h"
+#ifdef __LIBRETRO__
+#include "convert/simd.h"
+#endif
 #include "convert/routines.h"
 #include "resolution.h"
 #include "spec512.h"
@@ -109,6 +112,27 @@ static bool bRGBTableInSync;            /* Is RGB table up to date? */
 static bool bLibretroDoubleYEnable = 1; // used to disable Y doubling for low/medium resolutions
 static int coreRes = 0; // STRes if using ST resolution, otherwise an assumed mode based on GenConv dimensions.
 extern int core_video_aspect_adjust;
+// hatariB: threaded conversion, the worker converts frame N while frame N+1 is emulated
+extern bool core_video_threaded;
+extern void* core_video_buffer;
+static Uint8 *pConvertSTScreen;         // converter source, separate from pSTScreen which video.c advances during emulation
+static Uint16 *pConvertHBLPalettes;     // pFrameBuffer->HBLPalettes, video.c reuses pHBLPalettes during emulation
+static Uint32 *pConvertPaletteMasks = HBLPaletteMasks; // HBLPaletteMasks, or a copy of it while threaded
+static Uint32 ConvertPaletteMasks[HBL_PALETTE_MASKS];
+static Uint8 *pConvertSpare;            // third raster buffer, video.c fills it while the worker reads the other two
+static Uint8 *pConvertPresent;          // finished frame given to the core, so the worker can write to sdlscrn
+static size_t ConvertPresentSize;
+static void (*pConvertFunction)(void);
+static SDL_Thread *pConvertThread;
+static SDL_sem *pConvertStartSem;
+static SDL_sem *pConvertDoneSem;
+static bool bConvertPending;            // worker has a frame, must call Screen_ConvertFinish before touching sdlscrn
+static bool bConvertForceFlip;
+static bool bConvertQuit;
+static void Screen_ConvertFinish(bool bPresent);
+static bool Screen_ConvertStart(void (*pDrawFunction)(void), bool bForceFlip);
+static bool bConvertSimd;               // host supports the convert/simd.h kernels
+static void (*Screen_ConvertSimdFunction(void (*pDrawFunction)(void)))(void);
 #endif
 
 /* These are used for the generic screen conversion functions */
@@ -167,6 +191,9 @@ void Screen_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Sint32 w, Sint32
 
 	rect.x = x; rect.y = y;
 	rect.w = w; rect.h = h;
+#ifdef __LIBRETRO__
+	Screen_GenConvInvalidate(); /* GUI dialogs draw over the converted screen */
+#endif
 	Screen_UpdateRects(screen, 1, &rect);
 }
 
@@ -222,7 +249,11 @@ static void Screen_ConvertHighRes(void)
 	int linewidth = 640 / 16;
 
 	Screen_GenConvert(VideoBase, pSTScreen, 640, 400, 1, linewidth, 0, 0, 0, 0, 0);
+#ifndef __LIBRETRO__
 	bScreenContentsChanged = true;
+#else
+	bScreenContentsChanged = !Screen_GenConvUnchanged();
+#endif
 }
 
 /**
@@ -925,6 +956,9 @@ static void Screen_SetSTResolution(bool bForceChange)
  */
 static void Screen_ChangeResolution(bool bForceChange)
 {
+#ifdef __LIBRETRO__
+	Screen_ConvertFinish(false); // sdlscrn may be replaced
+#endif
 	if (bUseVDIRes)
 	{
 		Screen_SetGenConvSize(VDIWidth, VDIHeight, bForceChange);
@@ -981,6 +1015,14 @@ void Screen_Init(void)
 	/* Allocate screen check workspace. */
 	FrameBuffer.pSTScreen = malloc(MAX_VDI_BYTES);
 	FrameBuffer.pSTScreenCopy = malloc(MAX_VDI_BYTES);
+#ifdef __LIBRETRO__
+	pConvertSpare = malloc(MAX_VDI_BYTES);
+	if (!pConvertSpare)
+		FrameBuffer.pSTScreenCopy = NULL;
+#if CONVERT_SIMD
+	bConvertSimd = ConvertSimd_Available();
+#endif
+#endif
 	if (!FrameBuffer.pSTScreen || !FrameBuffer.pSTScreenCopy)
 	{
 		fprintf(stderr, "ERROR: Failed to allocate frame buffer memory.\n");
@@ -1022,6 +1064,24 @@ void Screen_Init(void)
  */
 void Screen_UnInit(void)
 {
+#ifdef __LIBRETRO__
+	Screen_ConvertFinish(false);
+	if (pConvertThread)
+	{
+		bConvertQuit = true;
+		SDL_SemPost(pConvertStartSem);
+		SDL_WaitThread(pConvertThread, NULL);
+		pConvertThread = NULL;
+		bConvertQuit = false;
+	}
+	if (pConvertStartSem) SDL_DestroySemaphore(pConvertStartSem);
+	if (pConvertDoneSem) SDL_DestroySemaphore(pConvertDoneSem);
+	pConvertStartSem = pConvertDoneSem = NULL;
+	free(pConvertSpare);
+	free(pConvertPresent);
+	pConvertSpare = pConvertPresent = NULL;
+	ConvertPresentSize = 0;
+#endif
 	/* Free memory used for copies */
 	free(FrameBuffer.pSTScreen);
 	free(FrameBuffer.pSTScreenCopy);
@@ -1075,6 +1135,9 @@ void Screen_Reset(void)
  */
 void Screen_SetFullUpdate(void)
 {
+#ifdef __LIBRETRO__
+	Screen_GenConvInvalidate();
+#endif
 	/* Update frame buffers */
 	FrameBuffer.bFullUpdate = true;
 }
@@ -1090,6 +1153,7 @@ static void Screen_ClearScreen(void)
 	SDL_FillRect(sdlscrn, &STScreenRect, SDL_MapRGB(sdlscrn->format, 0, 0, 0));
 #else
 	SDL_FillRect(sdlscrn, &STScreenRect, STRGBPalette[0]); // use palette 0 because it looks better while emulation is paused
+	Screen_GenConvInvalidate();
 #endif
 }
 
@@ -1404,6 +1468,11 @@ static void Screen_SetConvertDetails(void)
 	pPCScreenDest += PCScreenOffsetY * PCScreenBytesPerLine + PCScreenOffsetX * (sdlscrn->format->BitsPerPixel/8);
 
 	pHBLPalettes = pFrameBuffer->HBLPalettes;     /* HBL palettes pointer */
+#ifdef __LIBRETRO__
+	pConvertSTScreen = pSTScreen;
+	pConvertHBLPalettes = pHBLPalettes;
+	pConvertPaletteMasks = HBLPaletteMasks;
+#endif
 	/* Not in TV-Mode? Then double up on Y: */
 	bScrDoubleY = !(ConfigureParams.Screen.nMonitorType == MONITOR_TYPE_TV);
 
@@ -1502,9 +1571,17 @@ static bool Screen_DrawFrame(bool bForceFlip)
 	void (*pDrawFunction)(void);
 	static bool bPrevFrameWasSpec512 = false;
 	SDL_Rect *sbar_rect;
+#ifdef __LIBRETRO__
+	bool bThreaded = core_video_threaded && !bUseHighRes && !Spec512_IsImage();
+#endif
 
 	assert(!bUseVDIRes);
 
+#ifdef __LIBRETRO__
+	/* Show the previous frame if it was converted on the worker thread */
+	Screen_ConvertFinish(bThreaded);
+#endif
+
 	/* Scan palette/resolution masks for each line and build up palette/difference tables */
 	new_res = Screen_ComparePaletteMask(STRes);
 	/* Did we change resolution this frame - allocate new screen if did so */
@@ -1555,12 +1632,27 @@ static bool Screen_DrawFrame(bool bForceFlip)
 		Screen_SetFullUpdateMask();
 		bPrevFrameWasSpec512 = false;
 	}
+#ifdef __LIBRETRO__
+	if (bConvertSimd)
+		pDrawFunction = Screen_ConvertSimdFunction(pDrawFunction);
+#endif
 
 	/* Store palette for screenshots
 	 * pDrawFunction may override this if it calls Screen_GenConvert */
 	ConvertPalette = STRGBPalette;
 	ConvertPaletteSize = (STRes == ST_MEDIUM_RES) ? 4 : 16;
 
+#ifdef __LIBRETRO__
+	/* Hand the frame to the worker, it will be shown at the next Screen_DrawFrame */
+	if (bThreaded && Screen_ConvertStart(pDrawFunction, bForceFlip))
+	{
+		Screen_UnLock();
+		pFrameBuffer->bFullUpdate = false;
+		pFrameBuffer->VerticalOverscanCopy = VerticalOverscan;
+		return false;
+	}
+#endif
+
 	if (pDrawFunction)
 		CALL_VAR(pDrawFunction);
 
@@ -1610,6 +1702,10 @@ void Screen_SetGenConvSize(int width, int height, bool bForceChange)
 	int screenwidth, screenheight, maxw, maxh;
 	int scalex, scaley, sbarheight;
 
+#ifdef __LIBRETRO__
+	Screen_ConvertFinish(false);
+#endif
+
 	/* constrain size request to user's desktop size */
 	Resolution_GetLimits(&maxw, &maxh, keep);
 
@@ -1745,6 +1841,11 @@ void Screen_GenConvUpdate(SDL_Rect *extra, bool forced)
 	/* Don't update anything on screen if video output is disabled */
 	if ( ConfigureParams.Screen.DisableVideo )
 		return;
+#ifdef __LIBRETRO__
+	/* hatariB: nothing new to deliver, the core can send a dupe frame */
+	if (!forced && !extra && Screen_GenConvUnchanged())
+		return;
+#endif
 
 	rects[0] = STScreenRect;
 	if (extra) {
@@ -1797,7 +1898,11 @@ static int AdjustLinePaletteRemap(int y)
 	int i;
 
 	/* Copy palette and convert to RGB in display format */
+#ifndef __LIBRETRO__
 	actHBLPal = pHBLPalettes + (y<<4);    /* offset in palette */
+#else
+	actHBLPal = pConvertHBLPalettes + (y<<4);
+#endif
 	for (i=0; i<16; i++)
 	{
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -1806,7 +1911,11 @@ static int AdjustLinePaletteRemap(int y)
 		STRGBPalette[i] = ST2RGB[*actHBLPal++];
 #endif
 	}
+#ifndef __LIBRETRO__
 	ScrUpdateFlag = HBLPaletteMasks[y];
+#else
+	ScrUpdateFlag = pConvertPaletteMasks[y];
+#endif
 	return ScrUpdateFlag;
 }
 
@@ -1871,6 +1980,11 @@ static Uint32* Double_ScreenLine32(Uint32 *line, int size)
 /* lookup tables and conversion macros */
 #include "convert/macros.h"
 
+#ifdef __LIBRETRO__
+/* hatariB: conversion may run on the worker thread while video.c advances pSTScreen */
+#define pSTScreen pConvertSTScreen
+#endif
+
 /* Conversion routines */
 
 #include "convert/low320x32.c"		/* LowRes To 320xH x 32-bit color */
@@ -1879,3 +1993,174 @@ static Uint32* Double_ScreenLine32(Uint32 *line, int size)
 #include "convert/low320x32_spec.c"	/* LowRes Spectrum 512 To 320xH x 32-bit color */
 #include "convert/low640x32_spec.c"	/* LowRes Spectrum 512 To 640xH x 32-bit color */
 #include "convert/med640x32_spec.c"	/* MediumRes Spectrum 512 To 640xH x 32-bit color */
+
+#ifdef __LIBRETRO__
+/* hatariB: SIMD variants of the normal low/medium resolution routines */
+#if CONVERT_SIMD
+#include "convert/low320x32_simd.c"	/* LowRes To 320xH x 32-bit color */
+#include "convert/low640x32_simd.c"	/* LowRes To 640xH x 32-bit color */
+#include "convert/med640x32_simd.c"	/* MediumRes To 640xH x 32-bit color */
+#endif
+
+/**
+ * Return the SIMD replacement for a normal conversion routine,
+ * or the routine itself (Spectrum 512, high resolution, GenConvert).
+ */
+static void (*Screen_ConvertSimdFunction(void (*pDrawFunction)(void)))(void)
+{
+#if CONVERT_SIMD
+	if (pDrawFunction == ConvertLowRes_320x32Bit)
+		return ConvertLowRes_320x32Bit_Simd;
+	if (pDrawFunction == ConvertLowRes_640x32Bit)
+		return ConvertLowRes_640x32Bit_Simd;
+	if (pDrawFunction == ConvertMediumRes_640x32Bit)
+		return ConvertMediumRes_640x32Bit_Simd;
+#endif
+	return pDrawFunction;
+}
+#endif
+
+
+#ifdef __LIBRETRO__
+#undef pSTScreen
+
+/* -------------- threaded conversion --------------------------------------
+  hatariB: with core_video_threaded, Screen_DrawFrame hands the low/medium
+  resolution conversion to a worker thread and returns to emulation. The
+  worker reads its own copies of the raster and palette masks, and writes
+  to sdlscrn. The next Screen_DrawFrame (or anything else that changes the
+  screen) waits for it with Screen_ConvertFinish, and the finished frame is
+  shown one frame late from a copy, so the worker can reuse sdlscrn while
+  the frontend still holds the previous frame.
+*/
+
+static int Screen_ConvertThread(void *data)
+{
+	(void)data;
+	while (true)
+	{
+		SDL_SemWait(pConvertStartSem);
+		if (bConvertQuit)
+			break;
+		CALL_VAR(pConvertFunction);
+		SDL_SemPost(pConvertDoneSem);
+	}
+	return 0;
+}
+
+/**
+ * Start converting the current frame on the worker thread.
+ * Return false if it must be converted here instead.
+ */
+static bool Screen_ConvertStart(void (*pDrawFunction)(void), bool bForceFlip)
+{
+	static bool bConvertFailed = false;
+	Uint8 *pTmpScreen;
+
+	/* Spectrum 512 and high resolution conversion stay on the emulation thread */
+	if (pDrawFunction != ConvertLowRes_320x32Bit &&
+	    pDrawFunction != ConvertLowRes_640x32Bit &&
+	    pDrawFunction != ConvertMediumRes_640x32Bit
+#if CONVERT_SIMD
+	    && pDrawFunction != ConvertLowRes_320x32Bit_Simd
+	    && pDrawFunction != ConvertLowRes_640x32Bit_Simd
+	    && pDrawFunction != ConvertMediumRes_640x32Bit_Simd
+#endif
+	   )
+		return false;
+	/* the frontend must be showing the copy before the worker can write to sdlscrn */
+	if (!pConvertPresent || core_video_buffer != pConvertPresent || bConvertFailed)
+		return false;
+
+	if (!pConvertThread)
+	{
+		if (!pConvertStartSem) pConvertStartSem = SDL_CreateSemaphore(0);
+		if (!pConvertDoneSem) pConvertDoneSem = SDL_CreateSemaphore(0);
+		if (pConvertStartSem && pConvertDoneSem)
+			pConvertThread = SDL_CreateThread(Screen_ConvertThread, "hatarib_convert", NULL);
+		if (!pConvertThread)
+		{
+			core_error_printf("Unable to create video conversion thread: %s\n", SDL_GetError());
+			bConvertFailed = true;
+			return false;
+		}
+	}
+
+	/* video.c rewrites HBLPaletteMasks during the next frame */
+	memcpy(ConvertPaletteMasks, HBLPaletteMasks, sizeof(ConvertPaletteMasks));
+	pConvertPaletteMasks = ConvertPaletteMasks;
+
+	/* Rotate raster buffers: the worker compares current and previous, video.c fills the spare.
+	 * The current frame always becomes the previous, as Screen_Blit would do if it changed. */
+	pTmpScreen = pConvertSpare;
+	pConvertSpare = pFrameBuffer->pSTScreenCopy;
+	pFrameBuffer->pSTScreenCopy = pFrameBuffer->pSTScreen;
+	pFrameBuffer->pSTScreen = pTmpScreen;
+
+	pConvertFunction = pDrawFunction;
+	bConvertForceFlip = bForceFlip;
+	bConvertPending = true;
+	SDL_SemPost(pConvertStartSem);
+	return true;
+}
+
+/**
+ * Wait for the worker and show its frame.
+ * bPresent: the next frame will also be threaded, show it from a copy of sdlscrn.
+ * Otherwise the core is given sdlscrn again.
+ */
+static void Screen_ConvertFinish(bool bPresent)
+{
+	SDL_Rect *sbar_rect;
+	bool bChanged = false;
+	size_t size;
+
+	if (bConvertPending)
+	{
+		SDL_SemWait(pConvertDoneSem);
+		bConvertPending = false;
+
+		/* draw overlay led(s) or statusbar, as Screen_DrawFrame does after conversion */
+		Statusbar_OverlayBackup(sdlscrn);
+		sbar_rect = Statusbar_Update(sdlscrn, false);
+		bChanged = bScreenContentsChanged || bConvertForceFlip || sbar_rect;
+	}
+	if (!sdlscrn)
+		return;
+
+	if (bPresent)
+	{
+		size = (size_t)sdlscrn->pitch * sdlscrn->h;
+		if (size > ConvertPresentSize)
+		{
+			free(pConvertPresent);
+			pConvertPresent = malloc(size);
+			ConvertPresentSize = pConvertPresent ? size : 0;
+			if (!pConvertPresent)
+				bPresent = false;
+		}
+	}
+
+	if (bPresent)
+	{
+		if (bChanged || core_video_buffer != pConvertPresent)
+		{
+			memcpy(pConvertPresent, sdlscrn->pixels, size);
+			core_video_update(pConvertPresent, sdlscrn->w, sdlscrn->h, sdlscrn->pitch, coreRes);
+		}
+	}
+	else if (bChanged || (pConvertPresent && core_video_buffer == pConvertPresent))
+	{
+		core_video_update(sdlscrn->pixels, sdlscrn->w, sdlscrn->h, sdlscrn->pitch, coreRes);
+	}
+}
+
+/**
+ * Called by the core before it uses sdlscrn, or anything the worker may be using.
+ */
+extern void core_screen_convert_wait(void);
+void core_screen_convert_wait(void)
+{
+	Screen_ConvertFinish(false);
+}
+#endif
@@ -58,6 +58,101 @@ SDL_Color Screen_GetPaletteColor(Uint8 idx)
 	return palette.standard[idx];
 }
 
+#ifdef __LIBRETRO__
+/* hatariB: skip conversion when the source, palette and layout are unchanged since the last one */
+static struct
+{
+	void *pixels;
+	int vw, vh, vbpp, nextline, hscroll;
+	int leftBorder, rightBorder, upperBorder, lowerBorder;
+	int zoomx, zoomy, pitch, sampleHold;
+	Uint32 native[256];
+} GenConvLast;
+static Uint8 *pGenConvLastVram;
+static size_t GenConvLastVramSize;
+static bool bGenConvValid = false;
+static bool bGenConvUnchanged = false;
+
+/**
+ * The screen surface was changed outside Screen_GenConvert,
+ * the next conversion must be done in full.
+ */
+void Screen_GenConvInvalidate(void)
+{
+	bGenConvValid = false;
+	bGenConvUnchanged = false;
+}
+
+/**
+ * Return true if the last Screen_GenConvert was skipped because nothing changed.
+ */
+bool Screen_GenConvUnchanged(void)
+{
+	return bGenConvUnchanged;
+}
+
+static bool Screen_GenConvCompare(void *fvram, int vw, int vh, int vbpp, int nextline, int hscroll,
+                                  int leftBorder, int rightBorder, int upperBorder, int lowerBorder)
+{
+	size_t size;
+	bool bSame;
+
+	/* without dupe support every frame is delivered anyway, don't spend a compare and copy of video memory on it */
+	if (!core_video_can_dupe)
+	{
+		bGenConvValid = false;
+		return false;
+	}
+
+	/* every line of the source, including the extra word per plane read with horizontal scroll */
+	size = (size_t)vh * (size_t)(nextline + vbpp) * 2;
+	if ((Uint8*)fvram >= STRam && (Uint8*)fvram < STRam + sizeof(STRam) &&
+	    size > (size_t)(STRam + sizeof(STRam) - (Uint8*)fvram))
+		size = STRam + sizeof(STRam) - (Uint8*)fvram;
+
+	bSame = bGenConvValid &&
+		GenConvLast.pixels == sdlscrn->pixels &&
+		GenConvLast.vw == vw && GenConvLast.vh == vh && GenConvLast.vbpp == vbpp &&
+		GenConvLast.nextline == nextline && GenConvLast.hscroll == hscroll &&
+		GenConvLast.leftBorder == leftBorder && GenConvLast.rightBorder == rightBorder &&
+		GenConvLast.upperBorder == upperBorder && GenConvLast.lowerBorder == lowerBorder &&
+		GenConvLast.zoomx == nScreenZoomX && GenConvLast.zoomy == nScreenZoomY &&
+		GenConvLast.pitch == sdlscrn->pitch && GenConvLast.sampleHold == TTSpecialVideoMode &&
+		GenConvLastVramSize == size &&
+		!memcmp(GenConvLast.native, palette.native, sizeof(palette.native)) &&
+		!memcmp(pGenConvLastVram, fvram, size);
+	if (bSame)
+		return true;
+
+	if (size > GenConvLastVramSize || !pGenConvLastVram)
+	{
+		free(pGenConvLastVram);
+		pGenConvLastVram = malloc(size);
+	}
+	bGenConvValid = (pGenConvLastVram != NULL);
+	if (!bGenConvValid)
+		return false;
+	memcpy(pGenConvLastVram, fvram, size);
+	GenConvLastVramSize = size;
+	GenConvLast.pixels = sdlscrn->pixels;
+	GenConvLast.vw = vw;
+	GenConvLast.vh = vh;
+	GenConvLast.vbpp = vbpp;
+	GenConvLast.nextline = nextline;
+	GenConvLast.hscroll = hscroll;
+	GenConvLast.leftBorder = leftBorder;
+	GenConvLast.rightBorder = rightBorder;
+	GenConvLast.upperBorder = upperBorder;
+	GenConvLast.lowerBorder = lowerBorder;
+	GenConvLast.zoomx = nScreenZoomX;
+	GenConvLast.zoomy = nScreenZoomY;
+	GenConvLast.pitch = sdlscrn->pitch;
+	GenConvLast.sampleHold = TTSpecialVideoMode;
+	memcpy(GenConvLast.native, palette.native, sizeof(palette.native));
+	return false;
+}
+#endif
+
 void Screen_RemapPalette(void)
 {
 	int i;
@@ -75,6 +170,12 @@ void ScreenConv_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(palette.standard, sizeof(palette.standard));
 	if (!bSave)
 		Screen_RemapPalette();
+#ifdef __LIBRETRO__
+	/* hatariB: always convert and deliver the first frame after a restore, like a full update,
+	 * otherwise a same-instance run-ahead frame can be skipped as unchanged and show a stale screen */
+	if (!bSave)
+		Screen_GenConvInvalidate();
+#endif
 }
 
 static void Screen_memset_uint32(Uint32 *addr, Uint32 color, int count)
@@ -702,6 +803,14 @@ void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
 	if (ConvertPaletteSize > 256)
 		ConvertPaletteSize = 256;
 
+#ifdef __LIBRETRO__
+	bGenConvUnchanged = Screen_GenConvCompare(fvram, vw, vh, vbpp, nextline, hscroll,
+	                                          leftBorderSize, rightBorderSize,
+	                                          upperBorderSize, lowerBorderSize);
+	if (bGenConvUnchanged)
+		return;
+#endif
+
 	if (nScreenZoomX * nScreenZoomY != 1) {
 		Screen_ConvertWithZoom(fvram, vw, vh, vbpp, nextline, hscroll,
 		                       leftBorderSize, rightBorderSize,
@@ -719,6 +828,10 @@ bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
 {
 	int hscrolloffset;
 
+#ifdef __LIBRETRO__
+	if (core_video_skip) // hidden frame (palette updates are done by the caller)
+		return false;
+#endif
 	if (ConfigureParams.Screen.DisableVideo || !Screen_Lock())
 		return false;
 
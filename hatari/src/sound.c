@@ -149,6 +149,17 @@ const char Sound_fileid[] = "Hatari sound.c";
 #include "avi_record.h"
 #include "clocks_timings.h"
 
+#ifdef __LIBRETRO__
+// vector dot product for YM2149_Next_Resample_Sinc
+#if defined(__SSE2__)
+#define YM_SINC_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#define YM_SINC_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
 
 
 /*--------------------------------------------------------------*/
@@ -297,6 +308,9 @@ int		YM2149_Resample_Method = YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N;
 static double	pos_fract_nearest;			/* For YM2149_Next_Resample_Nearest */
 static double	pos_fract_weighted_2;			/* For YM2149_Next_Resample_Weighted_Average_2 */
 static uint32_t	pos_fract_weighted_n;			/* YM2149_Next_Resample_Weighted_Average_N */
+#ifdef __LIBRETRO__
+static uint32_t	pos_fract_sinc;				/* YM2149_Next_Resample_Sinc */
+#endif
 
 
 bool		bEnvelopeFreqFlag;			/* Cleared each frame for YM saving */
@@ -311,6 +325,10 @@ static int	AudioMixBuffer_pos_write_avi;		/* Current working index to save an AV
 
 bool		Sound_BufferIndexNeedReset = false;
 
+#ifdef __LIBRETRO__
+bool		YM2149_Block_Kernel = true;		/* false = original cycle by cycle loop (for bench/bench_ym.c) */
+#endif
+
 
 #define		YM_BUFFER_250_SIZE	32768		/* Size to store YM samples generated at 250 kHz (must be a power of 2) */
 							/* As we fill YM_Buffer_250[] at least once per VBL (min freq = 50 Hz) */
@@ -367,6 +385,9 @@ static ymu16	YM2149_EnvPer		(ymu8 rHigh , ymu8 rLow);
 static void	YM2149_Run		( uint64_t CPU_Clock );
 static int	Sound_GenerateSamples	( uint64_t CPU_Clock);
 static void	YM2149_DoSamples_250	( int SamplesToGenerate_250 );
+#ifdef __LIBRETRO__
+static int	YM2149_DoSamples_250_Block ( int SamplesToGenerate_250 , int pos );
+#endif
 #ifdef YM_250_DEBUG
 static void	YM2149_DoSamples_250_Debug ( int SamplesToGenerate , int pos );
 #endif
@@ -936,6 +957,12 @@ static void	Ym2149_Init(void)
 	/* Reset 250 Hz clock */
 	YM2149_Clock_250 = 0;
 	YM2149_Clock_250_CpuClock = CyclesGlobalClockCounter;
+#ifdef __LIBRETRO__
+	// start from the same state on every call (bench/bench_ym.c calls Sound_Init repeatedly)
+	YM2149_Freq_div_2 = 0;
+	YM2149_ConvertCycles_250.Cycles = 0;
+	YM2149_ConvertCycles_250.Remainder = 0;
+#endif
 
 	/* Clear internal YM audio buffer at 250 kHz */
 	memset ( YM_Buffer_250 , 0 , sizeof(YM_Buffer_250) );
@@ -1055,6 +1082,11 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 	/* that are not read yet */
 	pos = YM_Buffer_250_pos_write;
 
+#ifdef __LIBRETRO__
+	if ( YM2149_Block_Kernel )
+		pos = YM2149_DoSamples_250_Block ( SamplesToGenerate_250 , pos );
+	else
+#endif
 	/* Emulate as many internal YM cycles as needed to generate samples */
 	for ( n=0 ; n<SamplesToGenerate_250 ; n++ )
 	{
@@ -1156,6 +1188,216 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 }
 
 
+#ifdef __LIBRETRO__
+// Block version of the YM2149_DoSamples_250 loop, with the same output.
+// Between two events (a tone, noise or envelope counter reaching its period)
+// the output is constant, so each block fills the samples before the next
+// event in bulk, then runs the one cycle with the event exactly as above.
+// Counters that can't change the output (tone or noise disabled in the mixer,
+// voice at volume 0, envelope unused) don't end a block and are skipped ahead.
+
+// cycles until a tone or envelope counter reaches per (at least 1, as count++ is compared with >=)
+static inline int YM2149_Block_Until ( ymu16 count , ymu16 per )
+{
+	int t = (int)per - (int)count;
+	return ( t < 1 ) ? 1 : t;
+}
+
+// cycles until the noise counter reaches Noise_per, it is only increased on every second cycle
+static inline int YM2149_Block_Until_Noise ( void )
+{
+	if ( Noise_count >= Noise_per )
+		return 1;
+	return ( ( Noise_per - Noise_count ) * 2 ) - YM2149_Freq_div_2;
+}
+
+// advance the noise counter by cycles that don't reach Noise_per
+static inline void YM2149_Block_Advance_Noise ( int cycles )
+{
+	Noise_count += ( cycles + YM2149_Freq_div_2 ) >> 1;
+	YM2149_Freq_div_2 ^= ( cycles & 1 );
+}
+
+// advance a tone counter by any number of cycles, counting its toggles
+static inline void YM2149_Block_Skip_Tone ( ymu16 *count , ymu16 *val , ymu16 per , int cycles )
+{
+	int t = YM2149_Block_Until ( *count , per );
+	int p = per ? per : 1;
+	if ( cycles < t )
+	{
+		*count += cycles;
+		return;
+	}
+	cycles -= t;
+	if ( ( ( cycles / p ) & 1 ) == 0 )		/* 1 + cycles/p toggles */
+		*val ^= YM_SQUARE_UP;
+	*count = cycles % p;
+}
+
+static inline void YM2149_Block_Skip_Env ( int cycles )
+{
+	int t = YM2149_Block_Until ( Env_count , Env_per );
+	int p = Env_per ? Env_per : 1;
+	if ( cycles < t )
+	{
+		Env_count += cycles;
+		return;
+	}
+	cycles -= t;
+	Env_pos += 1 + ( cycles / p );
+	if ( Env_pos >= 3*32 )				/* loop blocks 1 and 2 */
+		Env_pos = 32 + ( ( Env_pos - 32 ) % ( 2*32 ) );
+	Env_count = cycles % p;
+}
+
+static inline void YM2149_Block_Skip_Noise ( int cycles )
+{
+	if ( Noise_per == 0 && cycles > 0 )		/* a new random value every cycle, often left like this with noise off */
+	{
+		ymu32 rnd = RndRack;
+		int i;
+		for ( i=1 ; i<cycles ; i++ )
+			rnd = ( rnd >> 1 ) ^ ( ( 0 - ( rnd & 1 ) ) & 0x12000 );
+		RndRack = rnd;
+		Noise_val = YM2149_RndCompute();
+		YM2149_Freq_div_2 ^= ( cycles & 1 );
+		Noise_count = 0;
+		return;
+	}
+	while ( cycles > 0 )
+	{
+		int t = YM2149_Block_Until_Noise ();
+		if ( cycles < t )
+		{
+			YM2149_Block_Advance_Noise ( cycles );
+			return;
+		}
+		YM2149_Block_Advance_Noise ( t - 1 );
+		YM2149_Freq_div_2 ^= 1;			/* the cycle with the event, as in YM2149_DoSamples_250 */
+		if ( YM2149_Freq_div_2 == 0 )
+			Noise_count++;
+		Noise_count = 0;
+		Noise_val = YM2149_RndCompute();
+		cycles -= t;
+	}
+}
+
+// current output, built as in YM2149_DoSamples_250
+static inline ymsample YM2149_Block_Sample ( void )
+{
+	ymu32	bt;
+	ymu16	Env3Voices;
+	ymu16	Tone3Voices;
+
+	Env3Voices = YmEnvWaves[ Env_shape ][ Env_pos ] & EnvMask3Voices;
+	bt = (ToneA_val | mixerTA) & (Noise_val | mixerNA);
+	Tone3Voices = bt & YM_MASK_1VOICE;
+	bt = (ToneB_val | mixerTB) & (Noise_val | mixerNB);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 5;
+	bt = (ToneC_val | mixerTC) & (Noise_val | mixerNC);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 10;
+	Tone3Voices &= ( Env3Voices | Vol3Voices );
+	return ymout5[ Tone3Voices ];
+}
+
+static int	YM2149_DoSamples_250_Block ( int SamplesToGenerate_250 , int pos )
+{
+	ymu16	Amp3Voices = EnvMask3Voices | Vol3Voices;	/* voices that can be heard */
+	bool	useA = ( Amp3Voices & YM_MASK_A ) && !mixerTA;
+	bool	useB = ( Amp3Voices & YM_MASK_B ) && !mixerTB;
+	bool	useC = ( Amp3Voices & YM_MASK_C ) && !mixerTC;
+	bool	useN = ( ( Amp3Voices & YM_MASK_A ) && !mixerNA )
+		    || ( ( Amp3Voices & YM_MASK_B ) && !mixerNB )
+		    || ( ( Amp3Voices & YM_MASK_C ) && !mixerNC );
+	bool	useE = ( EnvMask3Voices != 0 );
+	int	n = SamplesToGenerate_250;
+
+	while ( n > 0 )
+	{
+		int run = n, t;
+
+		/* cycles until the first event that changes the output */
+		if ( useA && ( t = YM2149_Block_Until ( ToneA_count , ToneA_per ) ) < run ) run = t;
+		if ( useB && ( t = YM2149_Block_Until ( ToneB_count , ToneB_per ) ) < run ) run = t;
+		if ( useC && ( t = YM2149_Block_Until ( ToneC_count , ToneC_per ) ) < run ) run = t;
+		if ( useE && ( t = YM2149_Block_Until ( Env_count , Env_per ) ) < run ) run = t;
+		if ( useN && ( t = YM2149_Block_Until_Noise () ) < run ) run = t;
+
+		/* constant output until the cycle before it */
+		if ( run > 1 )
+		{
+			ymsample sample = YM2149_Block_Sample ();
+			int fill = run - 1;
+			int i;
+
+			while ( fill > 0 )
+			{
+				int len = YM_BUFFER_250_SIZE - pos;
+				if ( len > fill )
+					len = fill;
+				for ( i=0 ; i<len ; i++ )
+					YM_Buffer_250[ pos + i ] = sample;
+				pos = ( pos + len ) & YM_BUFFER_250_SIZE_MASK;
+				fill -= len;
+			}
+
+			if ( useA ) ToneA_count += run - 1;
+			else YM2149_Block_Skip_Tone ( &ToneA_count , &ToneA_val , ToneA_per , run - 1 );
+			if ( useB ) ToneB_count += run - 1;
+			else YM2149_Block_Skip_Tone ( &ToneB_count , &ToneB_val , ToneB_per , run - 1 );
+			if ( useC ) ToneC_count += run - 1;
+			else YM2149_Block_Skip_Tone ( &ToneC_count , &ToneC_val , ToneC_per , run - 1 );
+			if ( useE ) Env_count += run - 1;
+			else YM2149_Block_Skip_Env ( run - 1 );
+			if ( useN ) YM2149_Block_Advance_Noise ( run - 1 );
+			else YM2149_Block_Skip_Noise ( run - 1 );
+		}
+
+		/* the cycle with the event */
+		YM2149_Freq_div_2 ^= 1;
+		if ( YM2149_Freq_div_2 == 0 )
+			Noise_count++;
+		if ( Noise_count >= Noise_per )
+		{
+			Noise_count = 0;
+			Noise_val = YM2149_RndCompute();
+		}
+		ToneA_count++;
+		if ( ToneA_count >= ToneA_per )
+		{
+			ToneA_count = 0;
+			ToneA_val ^= YM_SQUARE_UP;
+		}
+		ToneB_count++;
+		if ( ToneB_count >= ToneB_per )
+		{
+			ToneB_count = 0;
+			ToneB_val ^= YM_SQUARE_UP;
+		}
+		ToneC_count++;
+		if ( ToneC_count >= ToneC_per )
+		{
+			ToneC_count = 0;
+			ToneC_val ^= YM_SQUARE_UP;
+		}
+		Env_count += 1;
+		if ( Env_count >= Env_per )
+		{
+			Env_count = 0;
+			Env_pos += 1;
+			if ( Env_pos >= 3*32 )
+				Env_pos -= 2*32;
+		}
+		YM_Buffer_250[ pos ] = YM2149_Block_Sample ();
+		pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+
+		n -= run;
+	}
+	return pos;
+}
+#endif
+
+
 #ifdef YM_250_DEBUG
 /*-----------------------------------------------------------------------*/
 /**
@@ -1407,6 +1649,187 @@ static ymsample	YM2149_Next_Resample_Weighted_Average_2 ( void )
 
 
 
+#ifdef __LIBRETRO__
+// Band-limited polyphase resampler (YM2149_LPF_FILTER_SINC)
+//
+// Replaces the resample method and the lowpass filter with a single
+// windowed-sinc FIR filter evaluated only at the output sample times.
+// The filter for each output sample is picked from YM_SINC_PHASES phases
+// of the fractional read position, and spans YM_Sinc_Taps 250 kHz samples
+// ending at YM_Buffer_250_pos_read, so no extra margin is needed in
+// Sound_GenerateSamples at the cost of a delay of YM_Sinc_Taps/2 samples
+// (32 samples or 0.128 ms at 48 kHz, 0.144 ms at 44.1 kHz).
+//
+// The filter is a Kaiser windowed sinc with cutoff at 40% of the output rate,
+// about 12 output samples long (capped at YM_SINC_TAPS_MAX for low output
+// rates), with 16-bit coefficients normalized so that every phase has a
+// DC gain of exactly 1.
+// It is rebuilt whenever the output rate or the YM clock changes.
+
+#define YM_SINC_PHASES		128
+#define YM_SINC_TAPS_MAX	256		/* multiple of 8 */
+#define YM_SINC_LENGTH		12		/* output samples */
+#define YM_SINC_CUTOFF		0.40		/* fraction of the output rate */
+#define YM_SINC_KAISER_BETA	6.0
+
+static int16_t	YM_Sinc_Table[ YM_SINC_PHASES ][ YM_SINC_TAPS_MAX ] __attribute__((aligned(16)));
+static int	YM_Sinc_Taps = 0;
+static uint32_t	YM_Sinc_Interval = 0;		/* 16.16 250 kHz samples per output sample */
+static uint32_t	YM_Sinc_Freq_In = 0;
+static int	YM_Sinc_Freq_Out = 0;
+
+static double	YM2149_Sinc_I0 ( double x )
+{
+	double	sum = 1.0, term = 1.0;
+	int	k;
+
+	for ( k=1 ; k<50 ; k++ )
+	{
+		term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+		sum += term;
+		if ( term < sum * 1e-12 )
+			break;
+	}
+	return sum;
+}
+
+static void	YM2149_Sinc_Build ( void )
+{
+	double	h[ YM_SINC_TAPS_MAX ];
+	double	fc, half, i0_beta;
+	int	taps, p, k;
+
+	YM_Sinc_Freq_In = YM_ATARI_CLOCK_COUNTER;
+	YM_Sinc_Freq_Out = YM_REPLAY_FREQ;
+	YM_Sinc_Interval = ( YM_Sinc_Freq_In * 0x10000LL ) / YM_Sinc_Freq_Out;
+
+	taps = ( ( YM_SINC_LENGTH * YM_Sinc_Freq_In / YM_Sinc_Freq_Out ) + 7 ) & ~7;
+	if ( taps > YM_SINC_TAPS_MAX )
+		taps = YM_SINC_TAPS_MAX;
+	if ( taps < 8 )
+		taps = 8;
+	YM_Sinc_Taps = taps;
+
+	fc = YM_SINC_CUTOFF * YM_Sinc_Freq_Out / YM_Sinc_Freq_In;	/* cycles per 250 kHz sample */
+	half = taps / 2.0;
+	i0_beta = YM2149_Sinc_I0 ( YM_SINC_KAISER_BETA );
+
+	for ( p=0 ; p<YM_SINC_PHASES ; p++ )
+	{
+		double	sum = 0.0;
+		int	total = 0, kmax = 0;
+
+		for ( k=0 ; k<taps ; k++ )
+		{
+			double	u = k + 1 - half - ( (double)p / YM_SINC_PHASES );	/* distance from the output time */
+			double	r = u / half;
+			double	x = 2.0 * M_PI * fc * u;
+
+			h[k] = ( u == 0.0 ) ? 1.0 : sin ( x ) / x;
+			h[k] *= ( r*r < 1.0 ) ? YM2149_Sinc_I0 ( YM_SINC_KAISER_BETA * sqrt ( 1.0 - r*r ) ) / i0_beta : 0.0;
+			sum += h[k];
+		}
+		for ( k=0 ; k<taps ; k++ )
+		{
+			YM_Sinc_Table[p][k] = (int16_t)lrint ( h[k] * 32768.0 / sum );
+			total += YM_Sinc_Table[p][k];
+			if ( YM_Sinc_Table[p][k] > YM_Sinc_Table[p][kmax] )
+				kmax = k;
+		}
+		YM_Sinc_Table[p][kmax] += 32768 - total;		/* exact DC gain */
+		for ( ; k<YM_SINC_TAPS_MAX ; k++ )
+			YM_Sinc_Table[p][k] = 0;
+	}
+}
+
+static inline int32_t	YM2149_Sinc_Dot ( const ymsample *x , const int16_t *h , int taps )
+{
+	int	k;
+#if defined(YM_SINC_SSE2)
+	__m128i	acc = _mm_setzero_si128();
+	__m128i	acc2 = _mm_setzero_si128();
+
+	for ( k=0 ; k+16<=taps ; k+=16 )		/* two independent sums */
+	{
+		acc = _mm_add_epi32 ( acc , _mm_madd_epi16 ( _mm_loadu_si128 ( (const __m128i*)(x+k) ) , _mm_load_si128 ( (const __m128i*)(h+k) ) ) );
+		acc2 = _mm_add_epi32 ( acc2 , _mm_madd_epi16 ( _mm_loadu_si128 ( (const __m128i*)(x+k+8) ) , _mm_load_si128 ( (const __m128i*)(h+k+8) ) ) );
+	}
+	if ( k < taps )
+		acc = _mm_add_epi32 ( acc , _mm_madd_epi16 ( _mm_loadu_si128 ( (const __m128i*)(x+k) ) , _mm_load_si128 ( (const __m128i*)(h+k) ) ) );
+	acc = _mm_add_epi32 ( acc , acc2 );
+	acc = _mm_add_epi32 ( acc , _mm_shuffle_epi32 ( acc , _MM_SHUFFLE(1,0,3,2) ) );
+	acc = _mm_add_epi32 ( acc , _mm_shuffle_epi32 ( acc , _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_cvtsi128_si32 ( acc );
+#elif defined(YM_SINC_NEON)
+	int32x4_t	acc = vdupq_n_s32 ( 0 );
+
+	for ( k=0 ; k<taps ; k+=8 )
+	{
+		int16x8_t xv = vld1q_s16 ( x+k );
+		int16x8_t hv = vld1q_s16 ( h+k );
+		acc = vmlal_s16 ( acc , vget_low_s16 ( xv ) , vget_low_s16 ( hv ) );
+		acc = vmlal_s16 ( acc , vget_high_s16 ( xv ) , vget_high_s16 ( hv ) );
+	}
+	return vaddvq_s32 ( acc );
+#else
+	int32_t	acc = 0;
+
+	for ( k=0 ; k<taps ; k++ )
+		acc += (int32_t)x[k] * h[k];
+	return acc;
+#endif
+}
+
+static ymsample	YM2149_Next_Resample_Sinc ( void )
+{
+	ymsample	window[ YM_SINC_TAPS_MAX ] __attribute__((aligned(16)));
+	const ymsample	*x;
+	int		start;
+	int32_t		total;
+
+	if ( ( YM_Sinc_Freq_Out != YM_REPLAY_FREQ ) || ( YM_Sinc_Freq_In != YM_ATARI_CLOCK_COUNTER ) )
+		YM2149_Sinc_Build ();
+
+	start = ( YM_Buffer_250_pos_read - YM_Sinc_Taps + 1 ) & YM_BUFFER_250_SIZE_MASK;
+	if ( start + YM_Sinc_Taps <= YM_BUFFER_250_SIZE )
+		x = &YM_Buffer_250[ start ];
+	else						/* window wraps around the ring buffer */
+	{
+		int len = YM_BUFFER_250_SIZE - start;
+		memcpy ( window , &YM_Buffer_250[ start ] , len * sizeof(ymsample) );
+		memcpy ( window + len , YM_Buffer_250 , ( YM_Sinc_Taps - len ) * sizeof(ymsample) );
+		x = window;
+	}
+
+	total = YM2149_Sinc_Dot ( x , YM_Sinc_Table[ pos_fract_sinc >> 9 ] , YM_Sinc_Taps );	/* 7 bits of phase */
+	total = ( total + 0x4000 ) >> 15;
+	if ( total > 32767 ) total = 32767;
+	if ( total < -32768 ) total = -32768;
+
+	pos_fract_sinc += YM_Sinc_Interval;
+	YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + ( pos_fract_sinc >> 16 ) ) & YM_BUFFER_250_SIZE_MASK;
+	pos_fract_sinc &= 0xffff;
+	return (ymsample)total;
+}
+#endif
+
+
+#ifdef __LIBRETRO__
+// output rate lowpass filter selected by YM2149_LPF_Filter (not used with YM2149_LPF_FILTER_SINC)
+static ymsample	YM2149_LowPass ( ymsample sample )
+{
+	switch (YM2149_LPF_Filter)
+	{
+		default:
+		case YM2149_LPF_FILTER_NONE:                                          break;
+		case YM2149_LPF_FILTER_LPF_STF: sample = LowPassFilter ( sample );    break;
+		case YM2149_LPF_FILTER_PWM:     sample = PWMaliasFilter ( sample );   break;
+		case YM2149_LPF_FILTER_IIR:     sample = IIRLowPassFilter ( sample ); break;
+	}
+	return sample;
+}
+#endif
+
 static ymsample	YM2149_NextSample_250 ( void )
 {
 #ifndef __LIBRETRO__
@@ -1424,6 +1847,8 @@ static ymsample	YM2149_NextSample_250 ( void )
 #else
 	// filters were mistakenly applied at the wrong frequency above
 	ymsample sample = 0;
+	if (YM2149_LPF_Filter == YM2149_LPF_FILTER_SINC) // resamples and filters in one pass
+		return YM2149_Next_Resample_Sinc();
 	switch (YM2149_Resample_Method)
 	{
 		case YM2149_RESAMPLE_METHOD_NEAREST:            sample = YM2149_Next_Resample_Nearest();            break;
@@ -1431,17 +1856,50 @@ static ymsample	YM2149_NextSample_250 ( void )
 		case YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N: sample = YM2149_Next_Resample_Weighted_Average_N(); break;
 		default: break;
 	}
-	switch (YM2149_LPF_Filter)
+	return YM2149_LowPass ( sample );
+#endif
+}
+
+#ifdef __LIBRETRO__
+// advances the read position exactly as YM2149_NextSample_250,
+// but without resampling or filtering (for hidden frames where the output is discarded)
+static void YM2149_SkipSample_250 ( void )
+{
+	if (YM2149_LPF_Filter == YM2149_LPF_FILTER_SINC)
 	{
-		default:
-		case YM2149_LPF_FILTER_NONE:                                          break;
-		case YM2149_LPF_FILTER_LPF_STF: sample = LowPassFilter ( sample );    break;
-		case YM2149_LPF_FILTER_PWM:     sample = PWMaliasFilter ( sample );   break;
-		case YM2149_LPF_FILTER_IIR:     sample = IIRLowPassFilter ( sample ); break;
+		if ( ( YM_Sinc_Freq_Out != YM_REPLAY_FREQ ) || ( YM_Sinc_Freq_In != YM_ATARI_CLOCK_COUNTER ) )
+			YM2149_Sinc_Build ();
+		pos_fract_sinc += YM_Sinc_Interval;
+		YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + ( pos_fract_sinc >> 16 ) ) & YM_BUFFER_250_SIZE_MASK;
+		pos_fract_sinc &= 0xffff;
+		return;
+	}
+	switch (YM2149_Resample_Method)
+	{
+		case YM2149_RESAMPLE_METHOD_NEAREST:
+			pos_fract_nearest += ( (double)YM_ATARI_CLOCK_COUNTER ) / YM_REPLAY_FREQ;
+			YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + (int)pos_fract_nearest ) & YM_BUFFER_250_SIZE_MASK;
+			pos_fract_nearest -= (int)pos_fract_nearest;
+			break;
+		case YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_2:
+			pos_fract_weighted_2 += ( (double)YM_ATARI_CLOCK_COUNTER ) / YM_REPLAY_FREQ;
+			YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + (int)pos_fract_weighted_2 ) & YM_BUFFER_250_SIZE_MASK;
+			pos_fract_weighted_2 -= (int)pos_fract_weighted_2;
+			break;
+		case YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N:
+			if ( pos_fract_weighted_n )
+			{
+				YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + 1 ) & YM_BUFFER_250_SIZE_MASK;
+				pos_fract_weighted_n -= 0x10000;
+			}
+			pos_fract_weighted_n += ( YM_ATARI_CLOCK_COUNTER * 0x10000LL ) / YM_REPLAY_FREQ;
+			YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + ( pos_fract_weighted_n >> 16 ) ) & YM_BUFFER_250_SIZE_MASK;
+			pos_fract_weighted_n &= 0xffff;
+			break;
+		default: break;
 	}
-	return sample;
-#endif
 }
+#endif
 
 
 /*-----------------------------------------------------------------------*/
@@ -1682,6 +2140,9 @@ void Sound_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&pos_fract_nearest, sizeof(pos_fract_nearest));
 	MemorySnapShot_Store(&pos_fract_weighted_2, sizeof(pos_fract_weighted_2));
 	MemorySnapShot_Store(&pos_fract_weighted_n, sizeof(pos_fract_weighted_n));
+#ifdef __LIBRETRO__
+	MemorySnapShot_Store(&pos_fract_sinc, sizeof(pos_fract_sinc)); // band-limited resampler
+#endif
 }
 
 
@@ -1774,6 +2235,31 @@ static int Sound_GenerateSamples(uint64_t CPU_Clock)
 			Crossbar_GenerateSamples(AudioMixBuffer_pos_write, Sample_Nbr);
 	}
 
+#ifdef __LIBRETRO__
+	else if (core_audio_skip || core_audio_turbo)
+	{
+		// hidden frame, or fast-forward: output is discarded or barely heard so the resampling can be skipped
+		// (not for Falcon above, where the crossbar ADC can record the YM output),
+		// the nearest 250 kHz sample still goes through the lowpass and DC filters
+		// so that their history is current when audio is heard again
+		while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
+		{
+			ymsample sample = YM_Buffer_250[ YM_Buffer_250_pos_read ];
+			YM2149_SkipSample_250();
+			if (YM2149_LPF_Filter != YM2149_LPF_FILTER_SINC)
+				sample = YM2149_LowPass ( sample );
+			if (Config_IsMachineST())
+				sample = Subsonic_IIR_HPF_Left ( sample );
+			AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = sample;
+			idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
+			Sample_Nbr++;
+		}
+		/* DmaSnd must still advance its FIFO, and its filters */
+		if ( Sample_Nbr > 0 && !Config_IsMachineST() )
+			DmaSnd_GenerateSamples(AudioMixBuffer_pos_write, Sample_Nbr);
+	}
+#endif
+
 	else if (!Config_IsMachineST())
 	{
 		while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
@@ -20,6 +20,9 @@ const char STMemory_fileid[] = "Hatari stMemory.c";
 #include "vdi.h"
 #include "m68000.h"
 #include "video.h"
+#ifdef __LIBRETRO__
+#include "cart.h"
+#endif
 
 /* STRam points to our ST Ram. Unless the user enabled SMALL_MEM where we have
  * to save memory, this includes all TOS ROM and IO hardware areas for ease
@@ -34,6 +37,14 @@ uint8_t STRam[16*1024*1024];
 
 uint32_t STRamEnd;		/* End of ST Ram, above this address is no-mans-land and ROM/IO memory */
 
+#ifdef __LIBRETRO__
+uint8_t STMemory_Dirty[STMEMORY_DIRTY_PAGES];	/* pages written since the last savestate */
+bool STMemory_SkipClear = false;	/* savestate restore will overwrite ST RAM, so reset doesn't need to clear it */
+static uint64_t STMemory_RomHash;	/* hash of the Cart/TOS area for savestate references */
+static bool STMemory_RomHashValid = false;
+extern bool bCaptureError;
+#endif
+
 
 
 uint32_t RAM_Bank0_Size;	/* Physical RAM on board in bank0 (in bytes) : 128, 512 or 2048 KB */
@@ -134,6 +145,9 @@ bool STMemory_SafeClear(uint32_t addr, unsigned int len)
 	{
 		if (addr + len < 0x1000000)
 		{
+#ifdef __LIBRETRO__
+			STMemory_DirtyRange(addr, len);
+#endif
 			memset(&STRam[addr], 0, len);
 		}
 		else
@@ -173,6 +187,9 @@ bool STMemory_SafeCopy(uint32_t addr, uint8_t *src, unsigned int len, const char
 	{
 		if (addr + len < 0x1000000)
 		{
+#ifdef __LIBRETRO__
+			STMemory_DirtyRange(addr, len);
+#endif
 			memcpy(&STRam[addr], src, len);
 		}
 		else
@@ -193,6 +210,53 @@ bool STMemory_SafeCopy(uint32_t addr, uint8_t *src, unsigned int len, const char
 }
 
 
+#ifdef __LIBRETRO__
+/**
+ * Mark a range of ST RAM as modified since the last savestate.
+ * Used for writes that bypass the memory banks.
+ */
+void STMemory_DirtyRange ( uint32_t addr , uint32_t len )
+{
+	uint32_t page, last;
+
+	if ( len == 0 || addr >= 0x1000000 )
+		return;
+	if ( len > 0x1000000 - addr )
+		len = 0x1000000 - addr;
+	last = ( addr + len - 1 ) >> STMEMORY_DIRTY_SHIFT;
+	for ( page = addr >> STMEMORY_DIRTY_SHIFT ; page <= last ; page++ )
+		STMemory_Dirty[ page ] = 1;
+}
+
+
+/**
+ * Invalidate the hash of the Cart/TOS area, after it has been (re)loaded.
+ */
+void STMemory_RomChanged ( void )
+{
+	STMemory_RomHashValid = false;
+}
+
+/**
+ * Hash of the Cart/TOS area, excluding IO memory and the cartridge workspace.
+ * This area is only written when TOS or the cartridge is loaded,
+ * so the hash is kept until STMemory_RomChanged() is called.
+ * The workspace of the built-in cartridge (old GEMDOS vector) is written
+ * when GEMDOS HD emulation starts, so it is stored with the savestate instead.
+ */
+static uint64_t STMemory_GetRomHash ( void )
+{
+	if ( !STMemory_RomHashValid )
+	{
+		STMemory_RomHash = core_hash ( &RomMem[0xE00000] , CART_OLDGEMDOS - 0xE00000 );
+		STMemory_RomHash ^= core_hash ( &RomMem[CART_GEMDOS] , 0xFF0000 - CART_GEMDOS ) * 0x100000001B3ULL;
+		STMemory_RomHashValid = true;
+	}
+	return STMemory_RomHash;
+}
+#endif
+
+
 /**
  * Save/Restore snapshot of RAM / ROM variables
  * ('MemorySnapShot_Store' handles type)
@@ -209,10 +273,48 @@ void STMemory_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&MMU_Conf_Expected, sizeof(MMU_Conf_Expected));
 
 	/* Only save/restore area of memory machine is set to, eg 1Mb */
+#ifndef __LIBRETRO__
 	MemorySnapShot_Store(STRam, STRamEnd);
+#else
+	/* hatariB: only pages written since the last savestate are copied, if the core can trust its buffer */
+	core_snapshot_ram(STRam, STRamEnd, STMemory_Dirty, 1 << STMEMORY_DIRTY_SHIFT);
+#endif
 
 	/* And Cart/TOS/Hardware area */
+#ifndef __LIBRETRO__
 	MemorySnapShot_Store(&RomMem[0xE00000], 0x200000);
+#else
+	/* hatariB: Cart/TOS area was already rebuilt by Reset_Cold during restore, */
+	/* so it can be stored as a hash reference that only needs to be verified, */
+	/* or omitted entirely from lean savestates (0 = data, 1 = hash, 2 = omitted). */
+	/* The cartridge workspace is always stored, see STMemory_GetRomHash. */
+	{
+		uint8_t RomRef = core_snapshot_lean ? 2 : core_snapshot_refs ? 1 : 0;
+		uint64_t RomHash = 0;
+
+		MemorySnapShot_Store(&RomRef, sizeof(RomRef));
+		if ( RomRef == 1 )
+		{
+			if ( bSave )
+				RomHash = STMemory_GetRomHash();
+			MemorySnapShot_Store(&RomHash, sizeof(RomHash));
+			if ( !bSave && RomHash != STMemory_GetRomHash() )
+			{
+				core_signal_error("Savestate TOS or cartridge does not match: ", ConfigureParams.Rom.szTosImageFileName);
+				bCaptureError = true;
+			}
+		}
+		if ( RomRef != 0 )
+			MemorySnapShot_Store(&RomMem[CART_OLDGEMDOS], CART_GEMDOS - CART_OLDGEMDOS); /* cartridge workspace */
+		else
+		{
+			MemorySnapShot_Store(&RomMem[0xE00000], 0xFF0000 - 0xE00000);
+			if ( !bSave )
+				STMemory_RomChanged();
+		}
+		MemorySnapShot_Store(&RomMem[0xFF0000], 0x10000);
+	}
+#endif
 
 	/* Save/restore content of TT RAM if TTRamSize_KB != 0 */
 	if ( ConfigureParams.Memory.TTRamSize_KB > 0 )
@@ -238,6 +340,9 @@ void STMemory_SetDefaultConfig(void)
 	uint8_t MMU_Conf_Force;
 	uint8_t nFalcSysCntrl;
 
+#ifdef __LIBRETRO__
+	if (!STMemory_SkipClear) { // savestate restore will overwrite it anyway
+#endif
 	if (bRamTosImage)
 	{
 		/* Clear ST-RAM, excluding the RAM TOS image */
@@ -249,6 +354,9 @@ void STMemory_SetDefaultConfig(void)
 		/* Clear whole ST-RAM */
 		STMemory_SafeClear(0x00000000, STRamEnd);
 	}
+#ifdef __LIBRETRO__
+	}
+#endif
 
 	/* Mirror ROM boot vectors */
 	STMemory_WriteLong(0x00, STMemory_ReadLong(TosAddress));
@@ -1247,10 +1247,16 @@ int TOS_InitImage(void)
 	/* Copy loaded image into memory */
 #ifdef __LIBRETRO__
 	core_rom_mem_pointer = RomMem; // tell core where the ROM resides
+	STMemory_RomChanged(); // TOS and patches below
 	if (pTosFile) {
 #endif
 	if (bRamTosImage)
+	{
+#ifdef __LIBRETRO__
+		STMemory_DirtyRange(TosAddress, TosSize);
+#endif
 		memcpy(&STRam[TosAddress], pTosFile, TosSize);
+	}
 	else
 		memcpy(&RomMem[TosAddress], pTosFile, TosSize);
 	free(pTosFile);
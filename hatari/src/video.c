@@ -4480,6 +4480,10 @@ static void Video_DrawScreen(void)
 	}
 	else
 	{
+#ifdef __LIBRETRO__
+		if (core_video_skip) // hidden frame (Screen_GenDraw and VIDEL_renderScreen skip internally)
+			return;
+#endif
 		/* Before drawing the screen, ensure all unused lines are cleared to color 0 */
 		/* (this can happen in 60 Hz when hatari is displaying the screen's border) */
 		/* pSTScreen was set during Video_CopyScreenLineColor */